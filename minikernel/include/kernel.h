@@ -29,8 +29,102 @@
  **********************************************************
  */
 
+/*
+ * Parametros del sistema que se suman a los de const.h. Aquel fichero no
+ * se modifica porque HAL.o, que se distribuye compilado, se genero con el.
+ */
+#define ZOMBI 4 /* hilo terminado pendiente de esperar_hilo */
+
+/* NUM_MUT y NUM_MUT_PROC de const.h son los tamanos iniciales de la tabla
+   de mutex del sistema y de la de descriptores de un proceso, que crecen
+   bajo demanda */
+#ifndef MAX_MUT
+#define MAX_MUT 1024 /* numero maximo de mutex en el sistema; se puede
+                        fijar al compilar con -DMAX_MUT=n, n <= 65536 */
+#endif
+
+/* sustituye a TAM_BUF_TERM de const.h */
+#ifndef TAM_TERMINAL
+#define TAM_TERMINAL 64 /* tamano del buffer del terminal; se redondea a
+                           potencia de 2 y se puede fijar con -DTAM_TERMINAL=n */
+#endif
+
+/* constantes usadas en la implementacion de tuberias */
+#define MAX_FD_PROC 16 /* descriptores de fichero de un proceso */
+#define TAM_TUBERIA 1024 /* bytes de una tuberia, potencia de 2 */
+
+/* constantes usadas en la implementacion de memoria compartida */
+#define MAX_SEG_PROC 8 /* segmentos proyectados a la vez por un proceso */
+#define MAX_TAM_SEG (1 << 20) /* tamano maximo de un segmento */
+
+/* constantes usadas en la implementacion de ficheros */
+#define DIR_FICHEROS "ficheros" /* directorio del anfitrion con los ficheros */
+#define MAX_NOM_FICH 16 /* longitud maxima de un nombre de fichero */
+#define MAX_INODOS 16 /* ficheros del anfitrion abiertos a la vez */
+#define TAM_PAGINA 4096 /* bytes de una pagina de la cache de ficheros */
+#ifndef NUM_PAGINAS
+#define NUM_PAGINAS 64 /* paginas de la cache; se puede fijar con
+                          -DNUM_PAGINAS=n */
+#endif
+#define PAGINAS_ANTICIPADAS 4 /* paginas que se leen de una vez en una
+                                 lectura secuencial */
+#define TICKS_VOLCADO 100 /* cada cuanto se escriben las paginas sucias */
+
+/* constante usada en la cola de salida de la consola */
+#ifndef TAM_CONSOLA
+#define TAM_CONSOLA 8192 /* bytes de salida pendientes como maximo; se
+                            redondea a potencia de 2 */
+#endif
+
 #define NO_RECURSIVO 0
 #define RECURSIVO 1
+#define TRASPASO 2 /* unlock cede la propiedad al primero que espera */
+
+/* clases de objetos de sincronizacion con nombre */
+#define CLASE_MUTEX 0
+#define CLASE_SEMAFORO 1
+#define CLASE_CONDICION 2
+#define CLASE_LECTESC 3
+#define CLASE_BARRERA 4
+#define CLASE_CUENTA 5 /* cuenta atras */
+#define CLASE_COLA 6 /* cola de mensajes */
+#define CLASE_SEGMENTO 7 /* segmento de memoria compartida */
+
+#define NUM_PRIO_COLA 8 /* prioridades de los mensajes, de 0 a 7 (la mas urgente) */
+
+/* politicas de los cerrojos de lectura/escritura */
+#define LECTESC_PREF_ESCRITOR 0 /* al liberar se prefiere al siguiente escritor */
+#define LECTESC_EQUITATIVO 1 /* al liberar un escritor pasan los lectores que esperan */
+
+#define BITS_SLOT_MUT 16 /* bits del identificador de mutex para la entrada */
+#define MASCARA_SLOT_MUT ((1 << BITS_SLOT_MUT) - 1)
+#define MASCARA_GEN_MUT 0x7FFF /* generaciones posibles de una entrada */
+
+#define HASH_MUT_BORRADO (&mutex_borrado) /* marca de entrada borrada */
+
+#define BITS_PALABRA (8 * (int) sizeof(unsigned long))
+#define MAX_DESC_PROC (BITS_PALABRA * BITS_PALABRA) /* limite del mapa de
+                                                       descriptores de dos niveles */
+
+#define TAM_SLAB 4096 /* tamano de los slabs de las caches de objetos */
+#define TAM_LINEA_CACHE 64 /* alineamiento de los objetos de las caches */
+
+#define TAM_HASH_FUTEX 16 /* colas de espera de futex, potencia de 2 */
+
+/* redondeando hacia arriba y en 64 bits para que no desborde */
+#define MS_A_TICKS(ms) (((unsigned long long) (ms) * TICK + 999) / 1000)
+
+#define NUM_ESTAD_CERRADOS 16 /* nombres de mutex eliminados con estadisticas */
+
+#define LOTE_RECOLECCION 4 /* pendientes que fuerzan la recoleccion en una llamada */
+
+/*
+ * Recursos de procesos terminados sin liberar. Entre la entrada a una
+ * llamada, que deja menos de LOTE_RECOLECCION, y la siguiente se pueden
+ * anotar como mucho la pila y la imagen de cada proceso, las de un
+ * ejecutar y la memoria de cada objeto, asi que la tabla no se llena.
+ */
+#define MAX_PENDIENTES (LOTE_RECOLECCION + 2 * (MAX_PROC + 1) + MAX_MUT)
 
 
 /**********************************************************
@@ -48,8 +142,8 @@ typedef struct BCP_t *BCPptr;
 typedef struct BCP_t {
     int id;                     /* ident. del proceso */
     int estado;                 /* TERMINADO|LISTO|EJECUCION|BLOQUEADO*/
-    int nSegBlocked;            /* Numero de segundos que el proceso estara bloqueado */
-    int startBlockAt;           /* Numero de segundos que el proceso estara bloqueado */
+    int plazo;                  /* tick en que vence su espera temporizada, 0 si ninguna */
+    BCPptr siguiente_temp;      /* siguiente en lista_temporizados */
     contexto_t contexto_regs;   /* copia de regs. de UCP */
     void *pila;                 /* dir. inicial de la pila */
     BCPptr siguiente;           /* puntero a otro BCP */
@@ -57,11 +151,27 @@ typedef struct BCP_t {
     int intSistema;            /* interrupciones en modo sistema */
     int intUsuario;            /* interrupciones en modo usuario */
     int nMutex;                /* Contador del numero de mutex */
-    int mutexBlock;            /* Flag bloqueado por mutex */
-    int readBlock;             /* Flag bloqueado por lectura de caracter*/
+    int min_lectura;           /* caracteres que espera en el terminal */
     int ticks_restantes;
-    int mutexList[NUM_MUT_PROC];
-    int mutex_id;
+    int *mutexList;            /* objeto de cada descriptor, -1 si libre;
+                                  son de cada hilo, no de la imagen */
+    int *lecturas;             /* locks de lectura retenidos por descriptor, o 1
+                                  si es el de un participante de una barrera */
+    int tam_desc;              /* descriptores de mutexList */
+    unsigned long *desc_libres; /* bit a 1 por cada descriptor libre */
+    unsigned long resumen_desc; /* bit a 1 por cada palabra de desc_libres
+                                   con algun descriptor libre */
+    struct lista_BCPs_t *cola_espera; /* cola en la que esta bloqueado, o NULL */
+    int grupo;                 /* grupo de hilos que comparte info_mem */
+    void *funcion_hilo;        /* funcion inicial del hilo (crear_hilo) */
+    void *arg_hilo;            /* argumento de la funcion inicial del hilo */
+    int hilo_esperado;         /* id del hilo por el que espera, -1 si ninguno */
+    int valor_hilo;            /* valor de terminacion del hilo */
+    int *futex_dir;            /* palabra de usuario en la que espera, o NULL */
+    int no_bloqueante;         /* las lecturas del terminal no se bloquean */
+    char *salida_buf;          /* buffer de salida de la biblioteca, o NULL */
+    int *salida_lon;           /* bytes pendientes en salida_buf */
+    struct recursos_imagen_t *recursos; /* compartidos por los hilos del grupo */
 
 } BCP;
 
@@ -73,7 +183,7 @@ typedef struct BCP_t {
  *
  */
 
-typedef struct {
+typedef struct lista_BCPs_t {
     BCP *primero;
     BCP *ultimo;
 } lista_BCPs;
@@ -97,22 +207,244 @@ struct tiempos_ejec {
     int sistema;
 };
 
-typedef struct mutex_t *mutex_ptr;
+/*
+ * Estadisticas de uso de un mutex, con los tiempos en ticks de reloj.
+ * Se copian tal cual al usuario en la llamada estad_mutex.
+ */
+struct estad_mutex {
+    char nombre[MAX_NOM_MUT + 1];
+    int adquisiciones;          /* locks obtenidos, sin contar los recursivos */
+    int con_espera;             /* locks que tuvieron que bloquearse */
+    int desistidos;             /* trylock ocupados y lock_timeout vencidos */
+    int espera_total;
+    int espera_max;
+    int retencion_total;        /* tiempo con el mutex cerrado */
+    int retencion_max;
+    int propietario;            /* proceso que lo tiene cerrado, -1 si ninguno */
+    int esperando;              /* procesos bloqueados en el */
+};
+
+/*
+ * Fuente de eventos de esperar_eventos. El usuario rellena tipo e id
+ * (descriptor del mutex) y el kernel indica en listo si esta preparada.
+ */
+#define EV_TERMINAL 0 /* hay caracteres que leer */
+#define EV_MUTEX 1    /* el mutex esta abierto */
 
+struct evento {
+    int tipo;
+    int id;
+    int listo;
+};
+
+/*
+ * Recursos de un proceso terminado pendientes de liberar por el recolector
+ */
+typedef struct {
+    void *pila;                 /* pila a liberar, NULL si ninguna */
+    void *imagen;               /* imagen a liberar, NULL si ninguna */
+    void *memoria;              /* memoria dinamica a liberar, NULL si ninguna */
+} recurso_pendiente;
+
+/*
+ * Mensaje de recibir_lote: el usuario indica buf y tam y el kernel
+ * rellena lon y prioridad
+ */
+struct mensaje {
+    char *buf;
+    int tam;
+    int lon;
+    int prioridad;
+};
+
+/*
+ * Cabecera de cada hueco de una cola de mensajes
+ */
+typedef struct {
+    int siguiente;              /* siguiente hueco del carril o libre, -1 si ninguno */
+    int lon;
+    int prioridad;
+} cab_mensaje;
+
+/*
+ * Cola de mensajes: max_mensajes huecos de tam_max bytes reservados de una
+ * vez. Los huecos ocupados se encadenan en un carril FIFO por prioridad y
+ * los libres en una pila.
+ */
+typedef struct {
+    int tam_max;
+    int max_mensajes;
+    int num_mensajes;
+    int libres;                 /* primer hueco libre, -1 si ninguno */
+    int primero[NUM_PRIO_COLA]; /* cabeza y cola de cada carril, -1 si vacio */
+    int ultimo[NUM_PRIO_COLA];
+    unsigned int carriles;      /* bit a 1 por cada carril con mensajes */
+    cab_mensaje *cab;
+    char *datos;
+} cola_mensajes;
+
+/*
+ * Objeto con nombre: mutex, semaforo, variable condicion, cerrojo de
+ * lectura/escritura, barrera, cuenta atras, cola de mensajes o segmento
+ * de memoria compartida. Todas las clases comparten tabla, nombres y
+ * descriptores.
+ */
 typedef struct mutex_t {
     int index;
-    char nombre[MAX_NOM_MUT];
-    int tipo;
-    int proceso_bloqueado;
-    int num_procesos;
-    mutex_ptr siguiente;
+    char nombre[MAX_NOM_MUT + 1];
+    int clase;                  /* CLASE_MUTEX|CLASE_SEMAFORO|... */
+    int tipo;                   /* NO_RECURSIVO|RECURSIVO, mas TRASPASO, politica
+                                   LECTESC_* o participantes de la barrera */
+    int valor;                  /* contador del semaforo, llegadas que faltan a la
+                                   barrera, cuenta pendiente o tamano del segmento */
+    int proceso_bloqueado;      /* proceso que lo tiene cerrado, -1 si ninguno */
+    int num_bloqueos;           /* locks del propietario pendientes de unlock */
+    int num_procesos;           /* procesos que lo tienen abierto (y proyecciones
+                                   de los segmentos) */
+    int num_lectores;           /* locks de lectura concedidos */
+    lista_BCPs esperando;       /* procesos bloqueados en el objeto, en orden FIFO
+                                   (escritores en los de lectura/escritura y
+                                   emisores en las colas de mensajes) */
+    lista_BCPs esperando_lect;  /* lectores o receptores bloqueados, en orden FIFO */
+    int cerrado_desde;          /* tick en que lo obtuvo su propietario */
+    struct estad_mutex estad;   /* estadisticas de uso de los mutex */
+    cola_mensajes *mensajes;    /* mensajes de las colas, NULL en otras clases */
+    char *memoria;              /* memoria de los segmentos, NULL en otras clases */
 
 } mutex;
 
+/*
+ * Tuberia: buffer circular con colas de espera para cada extremo
+ */
+typedef struct {
+    char datos[TAM_TUBERIA];
+    unsigned int cabeza;        /* siguiente posicion a escribir */
+    unsigned int cola;          /* siguiente posicion a leer */
+    int lectores;               /* ficheros abiertos del extremo de lectura */
+    int escritores;             /* ficheros abiertos del extremo de escritura */
+    lista_BCPs esperan_lect;    /* lectores bloqueados con la tuberia vacia */
+    lista_BCPs esperan_escr;    /* escritores bloqueados con la tuberia llena */
+} tuberia;
+
+#define FICH_LECTURA 1
+#define FICH_ESCRITURA 2
+#define FICH_CREAR 4    /* abrir_fichero: lo crea si no existe */
+#define FICH_TRUNCAR 8  /* abrir_fichero: lo deja vacio */
+
+/* origen del desplazamiento de posicionar */
+#define POS_INICIO 0
+#define POS_ACTUAL 1
+#define POS_FINAL 2
+
+/*
+ * Fichero del anfitrion. Lo comparten todas las aperturas con el mismo
+ * nombre, para que vean las mismas paginas de la cache. Cerrado sigue
+ * abierto en el anfitrion mientras le queden paginas en la cache.
+ */
 typedef struct {
-    mutex *primero;
-    mutex *ultimo;
-} lista_Mutex;
+    char nombre[MAX_NOM_FICH + 1];
+    int fd;                     /* descriptor del anfitrion */
+    int escritura;              /* fd abierto tambien para escribir */
+    int refs;                   /* ficheros abiertos sobre el */
+    int paginas;                /* paginas en la cache; libre si no tiene
+                                   ni paginas ni refs */
+    unsigned int tam;           /* tamano, con lo escrito aun en la cache */
+} inodo;
+
+/*
+ * Fichero abierto: extremo de una tuberia o fichero del anfitrion. Lo
+ * comparten los descriptores heredados, y se cierra cuando se cierra el
+ * ultimo.
+ */
+typedef struct fichero_t {
+    int modo;                   /* FICH_LECTURA y/o FICH_ESCRITURA */
+    int refs;                   /* descriptores que lo referencian */
+    tuberia *tub;               /* NULL si es un fichero del anfitrion */
+    inodo *ino;                 /* NULL si es una tuberia */
+    unsigned int posicion;      /* siguiente byte a leer o escribir en ino */
+    int ultima_pagina;          /* ultima pagina leida, para detectar las
+                                   lecturas secuenciales */
+} fichero;
+
+/*
+ * Recursos de una imagen que comparten todos los hilos de su grupo. Se
+ * liberan cuando ningun hilo usa ya la imagen.
+ */
+typedef struct recursos_imagen_t {
+    fichero *fds[MAX_FD_PROC];  /* ficheros abiertos, NULL si libre */
+    int segmentos[MAX_SEG_PROC]; /* segmentos proyectados, -1 si libre */
+} recursos_imagen;
+
+/*
+ * Pagina de la cache de ficheros. Esta a la vez en la lista LRU, de la
+ * mas a la menos usada, y en una cadena de la tabla hash.
+ */
+typedef struct pagina_t {
+    inodo *ino;                 /* fichero de la pagina, NULL si libre */
+    unsigned int num;           /* numero de pagina dentro del fichero */
+    int sucia;                  /* modificada y sin escribir en el anfitrion */
+    struct pagina_t *anterior;  /* vecinas en la lista LRU */
+    struct pagina_t *siguiente;
+    struct pagina_t *sig_hash;
+    char datos[TAM_PAGINA];
+} pagina;
+
+/*
+ * Contadores de la cache de paginas. Se copian tal cual al usuario en la
+ * llamada estad_cache.
+ */
+struct estad_cache {
+    unsigned int aciertos;      /* paginas encontradas en la cache */
+    unsigned int fallos;        /* paginas pedidas que no estaban */
+    unsigned int anticipadas;   /* paginas leidas por adelantado */
+    unsigned int lecturas;      /* lecturas del anfitrion */
+    unsigned int escrituras;    /* escrituras en el anfitrion */
+};
+
+/*
+ * Cache de paginas de los ficheros del anfitrion. Las paginas sucias se
+ * escriben cada TICKS_VOLCADO ticks y al cerrar el fichero; las limpias
+ * se quedan hasta que las expulse la LRU.
+ */
+typedef struct {
+    pagina paginas[NUM_PAGINAS];
+    pagina *hash[NUM_PAGINAS];
+    pagina *mas_usada;
+    pagina *menos_usada;        /* la siguiente a expulsar */
+    int volcado_pendiente;      /* int_reloj pide escribir las sucias */
+    struct estad_cache estad;
+} cache_paginas;
+
+/*
+ * Objeto libre de una cache: se enlaza a traves de su propia memoria
+ */
+typedef struct objeto_libre_t {
+    struct objeto_libre_t *siguiente;
+} objeto_libre;
+
+/*
+ * Cache de objetos del kernel de un mismo tipo
+ */
+typedef struct {
+    const char *nombre;         /* tipo de objeto, para las estadisticas */
+    unsigned int tam_objeto;    /* tamano redondeado a TAM_LINEA_CACHE */
+    unsigned int objs_por_slab; /* objetos que caben en un slab */
+    objeto_libre *libres;       /* lista de objetos libres */
+    int num_slabs;              /* slabs pedidos al anfitrion */
+    int en_uso;                 /* objetos reservados actualmente */
+    int max_en_uso;             /* maximo de objetos reservados a la vez */
+    int reservas;               /* total de reservas */
+    int liberaciones;           /* total de liberaciones */
+} cache_objetos;
+
+/*
+ * Entrada de la tabla de mutex. La generacion se incrementa cada vez que
+ * se elimina el mutex que la ocupa y forma parte de su identificador.
+ */
+typedef struct {
+    mutex *pMutex;              /* mutex que ocupa la entrada, NULL si libre */
+    int generacion;             /* generacion actual de la entrada */
+} entrada_mutex;
 
 /**********************************************************
  ******************** GLOBAL VARIABLES ********************
@@ -143,6 +475,23 @@ lista_BCPs lista_listos = {NULL, NULL};
  */
 lista_BCPs lista_blocked = {NULL, NULL};
 
+/*
+ * Procesos bloqueados leyendo del terminal, por orden de llegada
+ */
+lista_BCPs lista_lectores = {NULL, NULL};
+
+/*
+ * Procesos bloqueados en esperar_eventos. Se despiertan todos ante
+ * cualquier cambio de una fuente y cada uno comprueba las suyas.
+ */
+lista_BCPs lista_eventos = {NULL, NULL};
+
+/*
+ * Procesos con una espera temporizada (dormir, lock_timeout), enlazados
+ * por siguiente_temp y ordenados por plazo
+ */
+BCP *lista_temporizados = NULL;
+
 /*
  * Variable global contador de llamadas al int_reloj
  */
@@ -154,9 +503,58 @@ int int_clock_counter = 0;
 int memAccess;
 
 /*
- * Lista global con los mutex que hay disponibles
+ * Cache de la que se reservan los mutex
+ */
+cache_objetos cache_mutex;
+
+cache_objetos cache_tuberias;
+
+cache_objetos cache_ficheros;
+
+cache_objetos cache_imagenes;
+
+/*
+ * Tabla global con los mutex que hay disponibles, indexada por la parte
+ * baja de su identificador. Crece por duplicacion hasta MAX_MUT.
  */
-lista_Mutex lista_mutex = {NULL, NULL};
+entrada_mutex *tabla_mutex = NULL;
+
+int tam_tabla_mutex = 0;
+
+/*
+ * Pila de entradas libres de tabla_mutex
+ */
+int *slots_libres_mutex = NULL;
+
+int num_slots_libres_mutex = 0;
+
+/*
+ * Tabla hash que indexa los mutex de tabla_mutex por su nombre. Su
+ * tamano es potencia de 2 y al menos el doble que el de tabla_mutex.
+ */
+mutex **hash_mutex = NULL;
+
+int tam_hash_mutex = 0;
+
+int num_borrados_hash = 0; /* entradas marcadas con HASH_MUT_BORRADO */
+
+/*
+ * Mutex ficticio cuya direccion marca las entradas borradas de hash_mutex
+ */
+mutex mutex_borrado;
+
+/*
+ * Colas de procesos bloqueados en futex_esperar, indexadas por la
+ * direccion de la palabra de usuario
+ */
+lista_BCPs colas_futex[TAM_HASH_FUTEX];
+
+/*
+ * Estadisticas acumuladas de los mutex ya eliminados, por nombre
+ */
+struct estad_mutex estad_cerrados[NUM_ESTAD_CERRADOS];
+
+int num_estad_cerrados = 0;
 
 /*
  * Variable global que lleva el contador del numero de mutex en el sistema
@@ -165,21 +563,82 @@ lista_Mutex lista_mutex = {NULL, NULL};
 int cont_mutex = 0;
 
 /*
- * Variable global generadora de indices de mutex
+ * Variable global generadora de identificadores de grupo de hilos
  */
 
-int cont_mutex_index = 0;
+int cont_grupos = 0;
 
 /*
-  * Variable global numero de caracteres en buffer
-  */
-int size_buffer = 0;
+ * Recursos de procesos terminados pendientes de liberar
+ */
+recurso_pendiente pendientes[MAX_PENDIENTES];
 
+int num_pendientes = 0;
 
 /*
- * Buffer de caracteres procesados del terminal
+ * Numero de imagenes creadas y aun no liberadas. Cuando se libera la
+ * ultima, el modulo HAL termina el sistema.
  */
-char buffer[TAM_BUF_TERM];
+int num_imagenes = 0;
+
+/*
+ * Modos del terminal: en el crudo cada caracter se entrega al llegar; en
+ * el canonico se entregan lineas completas y se tratan los caracteres
+ * de edicion
+ */
+#define MODO_CRUDO 0
+#define MODO_CANONICO 1
+
+#define CAR_BORRAR '\b'   /* borra el ultimo caracter de la linea */
+#define CAR_SUPRIMIR 0x7f /* igual que CAR_BORRAR */
+#define CAR_MATAR 0x15    /* control-U: borra toda la linea */
+
+/*
+ * Buffer circular de caracteres procesados del terminal. Solo escribe en
+ * el int_terminal y solo leen las llamadas de lectura, cada uno con su
+ * indice; los indices crecen sin limite y se reducen con la mascara. Los
+ * lectores solo ven hasta limite: entre limite y cabeza esta la linea
+ * que se edita en modo canonico, que en modo crudo siempre esta vacia.
+ */
+typedef struct {
+    char *datos;
+    unsigned int mascara;              /* capacidad - 1 */
+    volatile unsigned int cabeza;      /* siguiente posicion a escribir */
+    volatile unsigned int limite;      /* fin de lo que se puede leer */
+    volatile unsigned int cola;        /* siguiente posicion a leer */
+    unsigned int max_pendientes;       /* maximo de caracteres pendientes */
+    unsigned long desbordamientos;     /* caracteres descartados por lleno */
+} buffer_terminal;
+
+buffer_terminal buf_term;
+
+int modo_term = MODO_CRUDO;
+
+/*
+ * Cola de salida de la consola. escribir copia aqui el texto y vuelve;
+ * se vuelca a la pantalla por lotes cuando no hay procesos listos, cada
+ * TICKS_VACIADO ticks (desde int_sw), al entrar en una llamada con la
+ * cola a medias, antes de cada printk y, si un proceso no cabe, en ese
+ * momento a su costa.
+ */
+#define TICKS_VACIADO 10
+
+typedef struct {
+    char *datos;
+    unsigned int mascara;              /* capacidad - 1 */
+    unsigned int cabeza;               /* siguiente posicion a escribir */
+    unsigned int cola;                 /* siguiente posicion a volcar */
+    unsigned long volcados;            /* lotes escritos en pantalla */
+    unsigned long llenos;              /* escrituras que no cabian */
+    int vaciando;                      /* hay un volcado en curso */
+    int vaciado_pendiente;             /* int_reloj pide volcar */
+} cola_consola;
+
+cola_consola consola;
+
+cache_paginas cache_pag;
+
+inodo tabla_inodos[MAX_INODOS];
 
 
 /*
@@ -219,6 +678,126 @@ int sis_cerrar_mutex();
 
 int sis_leer_caracter();
 
+int sis_crear_hilo();
+
+int sis_datos_hilo();
+
+int sis_terminar_hilo();
+
+int sis_esperar_hilo();
+
+int sis_ejecutar();
+
+int sis_futex_esperar();
+
+int sis_futex_despertar();
+
+int sis_crear_sem();
+
+int sis_abrir_sem();
+
+int sis_sem_esperar();
+
+int sis_sem_senalar();
+
+int sis_cerrar_sem();
+
+int sis_crear_cond();
+
+int sis_abrir_cond();
+
+int sis_cond_esperar();
+
+int sis_cond_senalar();
+
+int sis_cond_difundir();
+
+int sis_cerrar_cond();
+
+int sis_crear_lectesc();
+
+int sis_abrir_lectesc();
+
+int sis_lock_lectura();
+
+int sis_lock_escritura();
+
+int sis_unlock_lectesc();
+
+int sis_cerrar_lectesc();
+
+int sis_crear_barrera();
+
+int sis_abrir_barrera();
+
+int sis_barrera_esperar();
+
+int sis_cerrar_barrera();
+
+int sis_crear_cuenta();
+
+int sis_abrir_cuenta();
+
+int sis_cuenta_descontar();
+
+int sis_cuenta_esperar();
+
+int sis_cerrar_cuenta();
+
+int sis_trylock();
+
+int sis_lock_timeout();
+
+int sis_estad_mutex();
+
+int sis_leer();
+
+int sis_modo_terminal();
+
+int sis_no_bloqueante();
+
+int sis_esperar_eventos();
+
+int sis_buffer_salida();
+
+int sis_escribirv();
+
+int sis_crear_tuberia();
+
+int sis_leer_fd();
+
+int sis_escribir_fd();
+
+int sis_cerrar_fd();
+
+int sis_crear_cola();
+
+int sis_abrir_cola();
+
+int sis_enviar();
+
+int sis_recibir();
+
+int sis_recibir_lote();
+
+int sis_cerrar_cola();
+
+int sis_crear_segmento();
+
+int sis_abrir_segmento();
+
+int sis_proyectar();
+
+int sis_desproyectar();
+
+int sis_cerrar_segmento();
+
+int sis_abrir_fichero();
+
+int sis_posicionar();
+
+int sis_estad_cache();
+
 /*
  * Variable global que contiene las rutinas que realizan cada llamada
  */
@@ -233,7 +812,67 @@ servicio tabla_servicios[NSERVICIOS] = {{sis_crear_proceso},
                                         {sis_lock},
                                         {sis_unlock},
                                         {sis_cerrar_mutex},
-                                        {sis_leer_caracter}
+                                        {sis_leer_caracter},
+                                        {sis_crear_hilo},
+                                        {sis_datos_hilo},
+                                        {sis_terminar_hilo},
+                                        {sis_esperar_hilo},
+                                        {sis_ejecutar},
+                                        {sis_futex_esperar},
+                                        {sis_futex_despertar},
+                                        {sis_crear_sem},
+                                        {sis_abrir_sem},
+                                        {sis_sem_esperar},
+                                        {sis_sem_senalar},
+                                        {sis_cerrar_sem},
+                                        {sis_crear_cond},
+                                        {sis_abrir_cond},
+                                        {sis_cond_esperar},
+                                        {sis_cond_senalar},
+                                        {sis_cond_difundir},
+                                        {sis_cerrar_cond},
+                                        {sis_crear_lectesc},
+                                        {sis_abrir_lectesc},
+                                        {sis_lock_lectura},
+                                        {sis_lock_escritura},
+                                        {sis_unlock_lectesc},
+                                        {sis_cerrar_lectesc},
+                                        {sis_crear_barrera},
+                                        {sis_abrir_barrera},
+                                        {sis_barrera_esperar},
+                                        {sis_cerrar_barrera},
+                                        {sis_crear_cuenta},
+                                        {sis_abrir_cuenta},
+                                        {sis_cuenta_descontar},
+                                        {sis_cuenta_esperar},
+                                        {sis_cerrar_cuenta},
+                                        {sis_trylock},
+                                        {sis_lock_timeout},
+                                        {sis_estad_mutex},
+                                        {sis_leer},
+                                        {sis_modo_terminal},
+                                        {sis_no_bloqueante},
+                                        {sis_esperar_eventos},
+                                        {sis_buffer_salida},
+                                        {sis_escribirv},
+                                        {sis_crear_tuberia},
+                                        {sis_leer_fd},
+                                        {sis_escribir_fd},
+                                        {sis_cerrar_fd},
+                                        {sis_crear_cola},
+                                        {sis_abrir_cola},
+                                        {sis_enviar},
+                                        {sis_recibir},
+                                        {sis_recibir_lote},
+                                        {sis_cerrar_cola},
+                                        {sis_crear_segmento},
+                                        {sis_abrir_segmento},
+                                        {sis_proyectar},
+                                        {sis_desproyectar},
+                                        {sis_cerrar_segmento},
+                                        {sis_abrir_fichero},
+                                        {sis_posicionar},
+                                        {sis_estad_cache}
 };
 
 #endif /* _KERNEL_H */
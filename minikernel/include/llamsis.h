@@ -18,8 +18,26 @@
 #ifndef _LLAMSIS_H
 #define _LLAMSIS_H
 
+/* Longitud maxima de un nombre de mutex; la comparte con la biblioteca
+   la estructura estad_mutex de la llamada estad_mutex */
+#define MAX_NOM_MUT 8
+
+/* Limites de escribir y escribirv: bytes de una llamada y fragmentos */
+#define MAX_ESCRITURA (1 << 20)
+#define MAX_FRAGMENTOS 64
+
+/* Fragmento de texto de escribirv */
+struct fragmento {
+    char *texto;
+    unsigned int longi;
+};
+
+/* Tamano del buffer de salida de escribirf_buf, que el kernel vacia si
+   el proceso muere con texto pendiente */
+#define TAM_BUF_SALIDA 1024
+
 /* Numero de llamadas disponibles */
-#define NSERVICIOS 12
+#define NSERVICIOS 72
 
 #define CREAR_PROCESO 0
 #define TERMINAR_PROCESO 1
@@ -33,6 +51,66 @@
 #define UNLOCK 9
 #define CERRAR_MUTEX 10
 #define LEER_CARACTER 11
+#define CREAR_HILO 12
+#define DATOS_HILO 13
+#define TERMINAR_HILO 14
+#define ESPERAR_HILO 15
+#define EJECUTAR 16
+#define FUTEX_ESPERAR 17
+#define FUTEX_DESPERTAR 18
+#define CREAR_SEM 19
+#define ABRIR_SEM 20
+#define SEM_ESPERAR 21
+#define SEM_SENALAR 22
+#define CERRAR_SEM 23
+#define CREAR_COND 24
+#define ABRIR_COND 25
+#define COND_ESPERAR 26
+#define COND_SENALAR 27
+#define COND_DIFUNDIR 28
+#define CERRAR_COND 29
+#define CREAR_LECTESC 30
+#define ABRIR_LECTESC 31
+#define LOCK_LECTURA 32
+#define LOCK_ESCRITURA 33
+#define UNLOCK_LECTESC 34
+#define CERRAR_LECTESC 35
+#define CREAR_BARRERA 36
+#define ABRIR_BARRERA 37
+#define BARRERA_ESPERAR 38
+#define CERRAR_BARRERA 39
+#define CREAR_CUENTA 40
+#define ABRIR_CUENTA 41
+#define CUENTA_DESCONTAR 42
+#define CUENTA_ESPERAR 43
+#define CERRAR_CUENTA 44
+#define TRYLOCK 45
+#define LOCK_TIMEOUT 46
+#define ESTAD_MUTEX 47
+#define LEER 48
+#define MODO_TERMINAL 49
+#define NO_BLOQUEANTE 50
+#define ESPERAR_EVENTOS 51
+#define BUFFER_SALIDA 52
+#define ESCRIBIRV 53
+#define CREAR_TUBERIA 54
+#define LEER_FD 55
+#define ESCRIBIR_FD 56
+#define CERRAR_FD 57
+#define CREAR_COLA 58
+#define ABRIR_COLA 59
+#define ENVIAR 60
+#define RECIBIR 61
+#define RECIBIR_LOTE 62
+#define CERRAR_COLA 63
+#define CREAR_SEGMENTO 64
+#define ABRIR_SEGMENTO 65
+#define PROYECTAR 66
+#define DESPROYECTAR 67
+#define CERRAR_SEGMENTO 68
+#define ABRIR_FICHERO 69
+#define POSICIONAR 70
+#define ESTAD_CACHE 71
 
 
 #endif /* _LLAMSIS_H */
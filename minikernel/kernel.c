@@ -17,6 +17,12 @@
 #include "kernel.h"    /* Contiene defs. usadas por este modulo */
 #include "string.h"
 #include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 
 
 /*
@@ -29,29 +35,120 @@
 
 bool verificaCondiciones(const char *nombre);
 
+static void vaciarConsola();
+
+/* printk escribe directamente en pantalla; antes se vuelca lo que quede en
+   la cola de la consola para que la traza salga en orden */
+#define printk(...) (vaciarConsola(), printk(__VA_ARGS__))
+
+static void soltarSegmentos(recursos_imagen *rec);
+
+static int volcarCache(inodo *ino);
+
+void iniciarTablaMutex();
+
 bool nombreMutexRepetido(const char *nombre);
 
 
 void anadirProcesoAListaBloqueados(BCP *proc);
 
 
-void insertar_mutex(lista_Mutex *lista, mutex *pMutex);
+int crearMutex(char *nombre, int clase, int tipo);
+
+int iniciarDescriptores(BCP *p_proc);
+
+int crecerDescriptores();
+
+int reservarDescriptor();
 
+void liberarDescriptor(int descriptor);
 
-void crearMutex(char *nombre, int tipo);
+int reconstruirHashMutex(int tam);
 
-int getDescriptor();
+int crecerTablaMutex(int tam);
 
-int getMutexId(const char *nombre);
+void eliminar_mutex(int mutex_id);
 
-void eliminar_mutex(lista_Mutex *lista, int mutex_id);
+mutex *getMutex(int mutex_id);
 
-void eliminar_primero_mutex(lista_Mutex *lista);
+mutex *buscarMutexPorNombre(const char *nombre);
 
-mutex *getMutex(lista_Mutex *lista, int mutex_id);
+void insertarHashMutex(mutex *pMutex);
+
+void eliminarHashMutex(mutex *pMutex);
 
 void eliminarProcesoListaBloqueados(BCP *proceso_bloqueado);
 
+void esperarMutex(mutex *pMutex);
+
+void esperarEnCola(lista_BCPs *cola, int plazo);
+
+BCP *despertarDeCola(lista_BCPs *cola);
+
+BCP *despertarPrimero(mutex *pMutex);
+
+int despertarTodos(lista_BCPs *cola);
+
+bool cederEscritor(mutex *pMutex);
+
+void despertarLectores(mutex *pMutex);
+
+void liberarLectura(mutex *pMutex);
+
+void liberarEscritura(mutex *pMutex);
+
+int adquirirMutexHasta(mutex *pMutex, int plazo);
+
+void adquirirMutex(mutex *pMutex);
+
+int lockMutex(unsigned int descriptor, int plazo, bool esperar);
+
+int plazoMs(unsigned int ms);
+
+void armarTemporizador(BCP *proc, int plazo);
+
+void quitarTemporizador(BCP *proc);
+
+void venceTemporizadores();
+
+void liberarMutex(mutex *pMutex);
+
+void anotarAdquisicion(mutex *pMutex, int inicio, bool con_espera);
+
+void leerEstadMutex(mutex *pMutex, struct estad_mutex *estad);
+
+void acumularEstadMutex(mutex *pMutex);
+
+void cerrarObjeto(mutex *pMutex, int lecturas);
+
+int crearObjeto(char *nombre, int clase, int tipo);
+
+int abrirObjeto(char *nombre, int clase);
+
+mutex *objetoDescriptor(unsigned int descriptor, int clase);
+
+int cerrarDescriptor(unsigned int descriptor, int clase);
+
+lista_BCPs *colaFutex(int *dir);
+
+bool imagenEnUso(int grupo);
+
+void liberarZombis(int grupo);
+
+void despertarEsperaHilo(int id);
+
+void notificarEventos();
+
+recursos_imagen *crearRecursos(recursos_imagen *padre);
+
+void soltarRecursos(recursos_imagen *rec);
+
+int soltarFichero(fichero *f);
+
+void vaciarSalida(BCP *proc);
+
+int comprobarEventos(struct evento *eventos, int n);
+
 /*
  * Funci�n que inicia la tabla de procesos
  */
@@ -77,7 +174,7 @@ static int buscar_BCP_libre() {
 /*
  *
  * Funciones que facilitan el manejo de las listas de BCPs
- *	insertar_ultimo eliminar_primero eliminar_elem
+ *	insertar_ultimo eliminar_primero eliminar_elem concatenar_lista
  *
  * NOTA: PRIMERO SE DEBE LLAMAR A eliminar Y LUEGO A insertar
  */
@@ -123,6 +220,207 @@ static void eliminar_elem(lista_BCPs *lista, BCP *proc) {
     }
 }
 
+/*
+ * Pasa todos los BCPs de la lista origen al final de la lista destino,
+ * dejando vacia la de origen.
+ */
+static void concatenar_lista(lista_BCPs *destino, lista_BCPs *origen) {
+    if (origen->primero == NULL)
+        return;
+    if (destino->primero == NULL)
+        destino->primero = origen->primero;
+    else
+        destino->ultimo->siguiente = origen->primero;
+    destino->ultimo = origen->ultimo;
+    origen->primero = NULL;
+    origen->ultimo = NULL;
+}
+
+/*
+ *
+ * Funciones del asignador de objetos del kernel
+ *	iniciar_cache crecer_cache reservar_objeto liberar_objeto
+ *
+ * Cada tipo de objeto tiene su propia cache formada por slabs de TAM_SLAB
+ * bytes alineados a linea de cache y troceados en objetos del mismo
+ * tamano. Los objetos libres forman una lista enlazada a traves de su
+ * propia memoria, de modo que reservar y liberar son O(1). Los slabs solo
+ * se piden al anfitrion cuando la cache se agota y no se devuelven nunca.
+ */
+
+/*
+ * Anade un slab nuevo a la cache. Devuelve -1 si no hay memoria.
+ */
+static int crecer_cache(cache_objetos *cache) {
+    void *slab;
+    char *obj;
+    unsigned int i;
+
+    if (posix_memalign(&slab, TAM_LINEA_CACHE, TAM_SLAB) != 0)
+        return -1;
+    obj = (char *) slab;
+    for (i = 0; i < cache->objs_por_slab; i++, obj += cache->tam_objeto) {
+        ((objeto_libre *) obj)->siguiente = cache->libres;
+        cache->libres = (objeto_libre *) obj;
+    }
+    cache->num_slabs++;
+    return 0;
+}
+
+/*
+ * Inicia una cache para objetos de tam bytes con sitio para al menos
+ * objs_iniciales objetos
+ */
+static void iniciar_cache(cache_objetos *cache, const char *nombre,
+                          unsigned int tam, int objs_iniciales) {
+    if (tam < sizeof(objeto_libre))
+        tam = sizeof(objeto_libre);
+    cache->nombre = nombre;
+    cache->tam_objeto = (tam + TAM_LINEA_CACHE - 1) & ~(TAM_LINEA_CACHE - 1);
+    cache->objs_por_slab = TAM_SLAB / cache->tam_objeto;
+    if (cache->objs_por_slab == 0)
+        panico("objeto demasiado grande para un slab");
+    cache->libres = NULL;
+    cache->num_slabs = 0;
+    cache->en_uso = 0;
+    cache->max_en_uso = 0;
+    cache->reservas = 0;
+    cache->liberaciones = 0;
+    while (cache->num_slabs * (int) cache->objs_por_slab < objs_iniciales)
+        if (crecer_cache(cache) < 0)
+            panico("no hay memoria para las caches del kernel");
+}
+
+/*
+ * Reserva un objeto de la cache. Devuelve NULL si no hay memoria.
+ */
+static void *reservar_objeto(cache_objetos *cache) {
+    objeto_libre *obj;
+
+    if (cache->libres == NULL && crecer_cache(cache) < 0)
+        return NULL;
+    obj = cache->libres;
+    cache->libres = obj->siguiente;
+    cache->reservas++;
+    if (++cache->en_uso > cache->max_en_uso)
+        cache->max_en_uso = cache->en_uso;
+    return obj;
+}
+
+/*
+ * Devuelve un objeto a su cache
+ */
+static void liberar_objeto(cache_objetos *cache, void *obj) {
+    ((objeto_libre *) obj)->siguiente = cache->libres;
+    cache->libres = (objeto_libre *) obj;
+    cache->liberaciones++;
+    cache->en_uso--;
+}
+
+/*
+ * Muestra el uso de una cache de objetos
+ */
+static void mostrar_cache(cache_objetos *cache) {
+    printk("   cache %s: objeto %d bytes, %d slabs, %d en uso (max %d), "
+           "%d reservas, %d liberaciones\n",
+           cache->nombre, cache->tam_objeto, cache->num_slabs,
+           cache->en_uso, cache->max_en_uso, cache->reservas,
+           cache->liberaciones);
+}
+
+static void mostrar_estad_mutex(struct estad_mutex *estad) {
+    printk("   mutex %s: %d locks (%d con espera, %d desistidos), espera %d ticks "
+           "(max %d), retencion %d ticks (max %d)\n",
+           estad->nombre, estad->adquisiciones, estad->con_espera,
+           estad->desistidos, estad->espera_total, estad->espera_max,
+           estad->retencion_total, estad->retencion_max);
+}
+
+/*
+ * Informe que se muestra al liberar la ultima imagen, justo antes de que
+ * el modulo HAL termine el sistema
+ */
+static void informe_apagado() {
+    int i;
+
+    printk("-> APAGADO DEL SISTEMA\n");
+    printk("-> CONSOLA: %lu volcados, %lu escrituras no cabian\n",
+           consola.volcados, consola.llenos);
+    printk("-> TERMINAL: %u de %u caracteres ocupados como maximo, %lu descartados\n",
+           buf_term.max_pendientes, buf_term.mascara + 1, buf_term.desbordamientos);
+    mostrar_cache(&cache_mutex);
+    mostrar_cache(&cache_tuberias);
+    mostrar_cache(&cache_ficheros);
+    mostrar_cache(&cache_imagenes);
+    volcarCache(NULL);
+    printk("-> CACHE DE PAGINAS: %u aciertos, %u fallos, %u anticipadas, "
+           "%u lecturas y %u escrituras del anfitrion\n",
+           cache_pag.estad.aciertos, cache_pag.estad.fallos,
+           cache_pag.estad.anticipadas, cache_pag.estad.lecturas,
+           cache_pag.estad.escrituras);
+    for (i = 0; i < tam_tabla_mutex; i++)
+        if (tabla_mutex[i].pMutex != NULL && tabla_mutex[i].pMutex->clase == CLASE_MUTEX)
+            acumularEstadMutex(tabla_mutex[i].pMutex);
+    for (i = 0; i < num_estad_cerrados; i++)
+        mostrar_estad_mutex(&estad_cerrados[i]);
+}
+
+/*
+ *
+ * Funciones relacionadas con la liberacion diferida de recursos de los
+ * procesos terminados: diferir_liberacion diferir_memoria
+ *	recolectar_pendientes
+ *
+ * La terminacion solo anota la pila y la imagen del proceso; el recolector
+ * las libera por lotes desde el bucle de espera o a la entrada de una
+ * llamada al sistema. No se hace en int_reloj porque liberar_imagen y
+ * liberar_pila usan rutinas del anfitrion que no son seguras dentro de
+ * una interrupcion asincrona.
+ */
+
+/*
+ * Libera todos los recursos pendientes
+ */
+static void recolectar_pendientes() {
+    while (num_pendientes > 0) {
+        num_pendientes--;
+        if (pendientes[num_pendientes].pila != NULL)
+            liberar_pila(pendientes[num_pendientes].pila);
+        if (pendientes[num_pendientes].imagen != NULL) {
+            /* liberar la ultima imagen termina el sistema */
+            if (--num_imagenes == 0)
+                informe_apagado();
+            liberar_imagen(pendientes[num_pendientes].imagen);
+        }
+        if (pendientes[num_pendientes].memoria != NULL)
+            free(pendientes[num_pendientes].memoria);
+    }
+}
+
+/*
+ * Anota la pila y/o la imagen de un proceso para liberarlas mas tarde
+ */
+static void diferir_liberacion(void *pila, void *imagen) {
+    if (num_pendientes == MAX_PENDIENTES)
+        panico("tabla de recursos pendientes llena");
+    pendientes[num_pendientes].pila = pila;
+    pendientes[num_pendientes].imagen = imagen;
+    pendientes[num_pendientes].memoria = NULL;
+    num_pendientes++;
+}
+
+/*
+ * Anota memoria de malloc para liberarla mas tarde
+ */
+static void diferir_memoria(void *memoria) {
+    if (num_pendientes == MAX_PENDIENTES)
+        panico("tabla de recursos pendientes llena");
+    pendientes[num_pendientes].pila = NULL;
+    pendientes[num_pendientes].imagen = NULL;
+    pendientes[num_pendientes].memoria = memoria;
+    num_pendientes++;
+}
+
 /*
  *
  * Funciones relacionadas con la planificacion
@@ -137,6 +435,13 @@ static void espera_int() {
 
     //printk("-> NO HAY LISTOS. ESPERA INT\n");
 
+    /* Aprovecha que no hay procesos listos para liberar recursos y
+       volcar la salida y las paginas pendientes */
+    recolectar_pendientes();
+    vaciarConsola();
+    if (cache_pag.volcado_pendiente)
+        volcarCache(NULL);
+
     /* Baja al m�nimo el nivel de interrupci�n mientras espera */
     nivel = fijar_nivel_int(NIVEL_1);
     halt();
@@ -159,77 +464,44 @@ static BCP *planificador() {
  * Funcion auxiliar que termina proceso actual liberando sus recursos.
  * Usada por llamada terminar_proceso y por rutinas que tratan excepciones
  *
+ * Como puede ejecutarse tratando una excepcion, ni ella ni nada de lo que
+ * llama puede usar malloc o free: la memoria que haya que liberar se
+ * anota con diferir_liberacion o diferir_memoria.
+ *
  */
 static void liberar_proceso() {
-
-    printk("\n\n-> LIBERAR PROCESO\n");
-
     int i;
-    for (i = 0; i < NUM_MUT_PROC; i++) {
-        printf("******************** BUSCAMOS MUTEX DE ESTE PROCESO %d\n", p_proc_actual->id);
-        int mutex_id;
-        if ((mutex_id = p_proc_actual->mutexList[i]) == -1)continue;
-        printf("******************** MUTEX ID ENCONTRADO %d\n", mutex_id);
-        printf("******************** BUSCAMOS MUTEX EN LA LISTA\n");
-        mutex *mutex1 = getMutex(&lista_mutex, mutex_id);
-        printf("******************** MUTEX ENCONTRADO %s\n", mutex1->nombre);
-        if (mutex1->index != -1 && mutex1->proceso_bloqueado == p_proc_actual->id) {
-            printf("******************** DESBLOQUEAMOS MUTEX %d\n", mutex_id);
-            mutex1->proceso_bloqueado = -1;
-            mutex1->num_procesos--;
-            printf("******************** TIENE %d PROCESOS MAS\n", mutex1->num_procesos);
-            if (mutex1->num_procesos > 0)continue;
-            eliminar_mutex(&lista_mutex, mutex1->index);
-            strcpy(mutex1->nombre, "");
-            cont_mutex--;
-        }
-        printf("******************** BUSCAMOS PROCESOS BLOQUEADOS\n");
-        BCP *proceso_bloqueado = lista_blocked.primero;
-        bool encontrado = false;
-        while (proceso_bloqueado != NULL && !encontrado) {
-            printf("******************** BUSCAMOS PROCESO BLOQUEADO POR MUTEX\n");
-            if (proceso_bloqueado->estado == BLOQUEADO
-                && proceso_bloqueado->mutex_id == mutex_id) {
-                printf("******************** PROCESO ENCONTRADO: %d\n", proceso_bloqueado->id);
-                proceso_bloqueado->estado = LISTO;
-                proceso_bloqueado->mutexBlock = 0;
-                eliminarProcesoListaBloqueados(proceso_bloqueado);
-                encontrado = true;
-            }
-            proceso_bloqueado = proceso_bloqueado->siguiente;
-        }
-
-
-        proceso_bloqueado = lista_blocked.primero;
-        while (proceso_bloqueado != NULL) {
-            if (proceso_bloqueado->estado == BLOQUEADO
-                && proceso_bloqueado->mutexBlock == 1) {
-                proceso_bloqueado->estado = LISTO;
-                proceso_bloqueado->mutexBlock = 0;
-                eliminarProcesoListaBloqueados(proceso_bloqueado);
-                break;
-            }
-            proceso_bloqueado = proceso_bloqueado->siguiente;
-        }
-
-    }
-    printf("******************** PROCESADOS MUTEX DE ESTE PROCESO %d\n", p_proc_actual->id);
-
     BCP *p_proc_anterior;
 
-    liberar_imagen(p_proc_actual->info_mem); /* liberar mapa */
+    /* cierre implicito de los objetos que tenga abiertos */
+    for (i = 0; i < p_proc_actual->tam_desc; i++) {
+        mutex *mutex1 = getMutex(p_proc_actual->mutexList[i]);
+        if (mutex1 != NULL)
+            cerrarObjeto(mutex1, p_proc_actual->lecturas[i]);
+    }
+    iniciarDescriptores(p_proc_actual);
 
     p_proc_actual->estado = TERMINADO;
     eliminar_primero(&lista_listos); /* proc. fuera de listos */
+    despertarEsperaHilo(p_proc_actual->id);
+
+    /* La imagen y sus ficheros solo se liberan cuando termina el ultimo
+       hilo que la usa */
+    if (imagenEnUso(p_proc_actual->grupo))
+        p_proc_actual->estado = ZOMBI;
+    else {
+        vaciarSalida(p_proc_actual);
+        liberarZombis(p_proc_actual->grupo);
+        soltarRecursos(p_proc_actual->recursos);
+        diferir_liberacion(NULL, p_proc_actual->info_mem); /* liberar mapa */
+    }
 
     /* Realizar cambio de contexto */
     p_proc_anterior = p_proc_actual;
     p_proc_actual = planificador();
 
-    printk("-> C.CONTEXTO POR FIN: de %d a %d\n",
-           p_proc_anterior->id, p_proc_actual->id);
-
-    liberar_pila(p_proc_anterior->pila);
+    /* la pila se libera despues de abandonarla */
+    diferir_liberacion(p_proc_anterior->pila, NULL);
     cambio_contexto(NULL, &(p_proc_actual->contexto_regs));
     return; /* no deber�a llegar aqui */
 }
@@ -269,6 +541,7 @@ static void exc_mem() {
         panico("excepcion de memoria cuando estaba dentro del kernel");
 
 
+    memAccess = 0; /* la excepcion pudo darse copiando de un proceso */
     printk("-> EXCEPCION DE MEMORIA EN PROC %d\n", p_proc_actual->id);
     liberar_proceso();
 
@@ -276,59 +549,250 @@ static void exc_mem() {
 }
 
 /*
- * Tratamiento de interrupciones de terminal
+ *
+ * Cola de salida de la consola
+ *	iniciarConsola escribirConsola vaciarConsola
+ *
+ * Los indices se leen y modifican a NIVEL_3, pero la escritura en
+ * pantalla se hace al nivel del llamante: int_reloj solo pide el volcado,
+ * que hace int_sw.
  */
-static void int_terminal() {
-    char car;
 
-    car = leer_puerto(DIR_TERMINAL);
-    printk("-> TRATANDO INT. DE TERMINAL %c\n", car);
+static void iniciarConsola(unsigned int capacidad) {
+    unsigned int tam = 1;
+
+    while (tam < capacidad)
+        tam *= 2;
+    consola.datos = malloc(tam);
+    if (consola.datos == NULL)
+        panico("no hay memoria para la cola de la consola");
+    consola.mascara = tam - 1;
+    consola.cabeza = consola.cola = 0;
+    consola.volcados = consola.llenos = 0;
+    consola.vaciando = consola.vaciado_pendiente = 0;
+}
+
+/*
+ * Vuelca a la pantalla lo pendiente al entrar, en uno o dos trozos. Lo que
+ * se anada mientras tanto queda para el siguiente volcado. Si una
+ * interrupcion llega en medio y vuelve a llamarla, no hace nada.
+ */
+static void vaciarConsola() {
+    int int_level = fijar_nivel_int(NIVEL_3);
+    unsigned int cola = consola.cola;
+    unsigned int cabeza = consola.cabeza;
 
-    if (size_buffer >= TAM_BUF_TERM) {
-        printf("TAMANO DEL BUFFER EXCEDIDO %d\n", size_buffer);
+    if (consola.vaciando || cola == cabeza) {
+        fijar_nivel_int(int_level);
         return;
     }
+    consola.vaciando = 1;
+    consola.vaciado_pendiente = 0;
+    fijar_nivel_int(int_level);
 
-    printf("METEMOS EN BUFFER\n");
-    buffer[size_buffer] = car;
-    size_buffer++;
+    while (cola != cabeza) {
+        unsigned int inicio = cola & consola.mascara;
+        unsigned int longi = cabeza - cola;
 
-    BCP *proc_blocked = lista_blocked.primero;
-    bool desbloqueado = false;
+        if (longi > consola.mascara + 1 - inicio)
+            longi = consola.mascara + 1 - inicio;
+        escribir_ker(&consola.datos[inicio], longi);
+        cola += longi;
+        consola.volcados++;
+    }
 
+    int_level = fijar_nivel_int(NIVEL_3);
+    consola.cola = cola;
+    consola.vaciando = 0;
+    fijar_nivel_int(int_level);
+}
 
-    if (proc_blocked != NULL && proc_blocked->readBlock == 1) {
-        printf("PRIMERO BLOQUEADO POR LECTURA, DESBLOQUEAMOS\n");
-        desbloqueado = true;
-        proc_blocked->estado = LISTO;
-        proc_blocked->readBlock = 0;
+/*
+ * Copia el texto en la cola. Si no cabe se vacia antes la cola, y si no
+ * cabria ni vacia se escribe directamente.
+ */
+static void escribirConsola(char *texto, unsigned int longi) {
+    if (longi > consola.mascara + 1 - (consola.cabeza - consola.cola)) {
+        consola.llenos++;
+        vaciarConsola();
+    }
 
-        int int_level = fijar_nivel_int(NIVEL_3);
-        eliminar_elem(&lista_blocked, proc_blocked);
-        insertar_ultimo(&lista_listos, proc_blocked);
+    int int_level = fijar_nivel_int(NIVEL_3);
+    if (longi > consola.mascara + 1 - (consola.cabeza - consola.cola)) {
         fijar_nivel_int(int_level);
-
+        escribir_ker(texto, longi);
+        return;
     }
 
-    while (!desbloqueado && proc_blocked != lista_blocked.ultimo) {
-        printf("SEGUIMOS DESBLOQUEANDO\n");
-        proc_blocked = proc_blocked->siguiente;
-        if (proc_blocked->readBlock == 1) {
+    unsigned int inicio = consola.cabeza & consola.mascara;
+    unsigned int primero = consola.mascara + 1 - inicio;
 
-            desbloqueado = true;
-            proc_blocked->estado = LISTO;
-            proc_blocked->readBlock = 0;
+    if (primero > longi)
+        primero = longi;
+    memcpy(&consola.datos[inicio], texto, primero);
+    memcpy(consola.datos, texto + primero, longi - primero);
+    consola.cabeza += longi;
+    fijar_nivel_int(int_level);
+}
 
-            printf("CAMBIO DE CONTEXTO\n");
-            int int_level = fijar_nivel_int(NIVEL_3);
-            eliminar_elem(&lista_blocked, proc_blocked);
-            insertar_ultimo(&lista_listos, proc_blocked);
-            fijar_nivel_int(int_level);
+/*
+ *
+ * Buffer circular del terminal
+ *	iniciarBufferTerminal meterBufferTerminal editarLineaTerminal
+ *	sacarBufferTerminal
+ *
+ */
 
-        }
+/*
+ * Reserva el buffer con la menor potencia de 2 que sea mayor o igual
+ * que la capacidad pedida
+ */
+static void iniciarBufferTerminal(unsigned int capacidad) {
+    unsigned int tam = 1;
+
+    while (tam < capacidad)
+        tam *= 2;
+    buf_term.datos = malloc(tam);
+    if (buf_term.datos == NULL)
+        panico("no hay memoria para el buffer del terminal");
+    buf_term.mascara = tam - 1;
+    buf_term.cabeza = buf_term.limite = buf_term.cola = 0;
+    buf_term.max_pendientes = 0;
+    buf_term.desbordamientos = 0;
+}
+
+/*
+ * Productor: solo se llama desde int_terminal. Devuelve -1 si el
+ * buffer esta lleno y el caracter se descarta.
+ */
+static int meterBufferTerminal(char car) {
+    unsigned int pendientes = buf_term.cabeza - buf_term.cola;
+
+    if (pendientes > buf_term.mascara) {
+        buf_term.desbordamientos++;
+        return -1;
+    }
+    buf_term.datos[buf_term.cabeza & buf_term.mascara] = car;
+    buf_term.cabeza++;
+    if (pendientes + 1 > buf_term.max_pendientes)
+        buf_term.max_pendientes = pendientes + 1;
+    return 0;
+}
+
+/*
+ * Hace visible a los lectores lo escrito hasta cabeza
+ */
+static void publicarBufferTerminal() {
+    __sync_synchronize(); /* los caracteres se escriben antes que el indice */
+    buf_term.limite = buf_term.cabeza;
+}
+
+/*
+ * Disciplina de linea del modo canonico. Devuelve true si queda una
+ * linea completa para los lectores. Si la linea llena el buffer se
+ * entrega tal cual para que se pueda vaciar.
+ */
+static bool editarLineaTerminal(char car) {
+    switch (car) {
+        case CAR_BORRAR:
+        case CAR_SUPRIMIR:
+            if (buf_term.cabeza != buf_term.limite)
+                buf_term.cabeza--;
+            return false;
+        case CAR_MATAR:
+            buf_term.cabeza = buf_term.limite;
+            return false;
+        case '\r':
+            car = '\n';
+            break;
     }
+    if (meterBufferTerminal(car) < 0 || car == '\n'
+        || buf_term.cabeza - buf_term.cola > buf_term.mascara) {
+        publicarBufferTerminal();
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Consumidor: solo se llama desde las llamadas de lectura. Devuelve -1
+ * si el buffer esta vacio.
+ */
+static int sacarBufferTerminal() {
+    unsigned int cola = buf_term.cola;
+    unsigned char car;
+
+    if (cola == buf_term.limite)
+        return -1;
+    car = buf_term.datos[cola & buf_term.mascara];
+    __sync_synchronize(); /* el caracter se lee antes de liberar el hueco */
+    buf_term.cola = cola + 1;
+    return car;
+}
+
+static unsigned int pendientesTerminal() {
+    return buf_term.limite - buf_term.cola;
+}
+
+/*
+ * Bloquea al proceso actual hasta que haya al menos min caracteres en el
+ * buffer. Se llama con las interrupciones del terminal prohibidas.
+ */
+static void esperarTerminal(int min) {
+    p_proc_actual->estado = BLOQUEADO;
+    p_proc_actual->min_lectura = min;
 
+    int int_level = fijar_nivel_int(NIVEL_3);
+    eliminar_elem(&lista_listos, p_proc_actual);
+    insertar_ultimo(&lista_lectores, p_proc_actual);
+    fijar_nivel_int(int_level);
+
+    BCP *p_proc_blocked = p_proc_actual;
+    p_proc_actual = planificador();
+    cambio_contexto(&(p_proc_blocked->contexto_regs), &(p_proc_actual->contexto_regs));
+}
+
+/*
+ * Desbloquea al primer lector si ya tiene los caracteres que espera. Se
+ * atiende por orden de llegada; el lector despertado, al terminar, llama
+ * de nuevo por si quedan caracteres para el siguiente.
+ */
+static void despertarLectorTerminal() {
+    BCP *proc = lista_lectores.primero;
+
+    if (proc == NULL || pendientesTerminal() < (unsigned int) proc->min_lectura)
+        return;
+    proc->estado = LISTO;
+    proc->min_lectura = 0;
+
+    int int_level = fijar_nivel_int(NIVEL_3);
+    eliminar_primero(&lista_lectores);
+    insertar_ultimo(&lista_listos, proc);
+    fijar_nivel_int(int_level);
+}
 
+/*
+ * Tratamiento de interrupciones de terminal
+ */
+static void int_terminal() {
+    char car;
+
+    car = leer_puerto(DIR_TERMINAL);
+    printk("-> TRATANDO INT. DE TERMINAL %c\n", car);
+
+    if (modo_term == MODO_CANONICO) {
+        /* solo se despierta a los lectores al completar una linea */
+        if (!editarLineaTerminal(car))
+            return;
+    } else if (meterBufferTerminal(car) < 0) {
+        printk("-> BUFFER DEL TERMINAL LLENO: %lu caracteres descartados\n",
+               buf_term.desbordamientos);
+        return;
+    } else
+        publicarBufferTerminal();
+
+    despertarLectorTerminal();
+    notificarEventos();
     return;
 }
 
@@ -352,26 +816,14 @@ static void int_reloj() {
 
     }
 
-    BCP *first_blocked = lista_blocked.primero;
-    while (first_blocked != NULL) {
-        //printf("******************** HAY PROCESO BLOCKED (%d)\n", first_blocked->id);
-        int seg_left =
-                (first_blocked->nSegBlocked * TICK) - (int_clock_counter - first_blocked->startBlockAt);
-        BCPptr next_blocked = first_blocked->siguiente;
-        // printf("******************** LE QUEDAN (%d)\n", seg_left);
-        if (seg_left <= 0 &&
-            first_blocked->mutexBlock != 1) {
-            //  printf("******************** DESBLOQUEAMOS \n");
-            first_blocked->estado = LISTO;
-            eliminarProcesoListaBloqueados(first_blocked);
-            // printf("******************** DONE \n");
-
-        }
-        //  printf("******************** PASAMOS SIGUIENTE\n");
-
-        first_blocked = next_blocked;
+    venceTemporizadores();
+    if (int_clock_counter % TICKS_VACIADO == 0 &&
+        consola.cola != consola.cabeza) {
+        consola.vaciado_pendiente = 1;
+        activar_int_SW();
     }
-    // printf("******************** NO HAY PROCESO BLOCKED\n\n");
+    if (int_clock_counter % TICKS_VOLCADO == 0)
+        cache_pag.volcado_pendiente = 1;
     return;
 }
 
@@ -381,6 +833,13 @@ static void int_reloj() {
 static void tratar_llamsis() {
     int nserv, res;
 
+    if (num_pendientes >= LOTE_RECOLECCION)
+        recolectar_pendientes();
+    if (consola.cabeza - consola.cola > consola.mascara / 2)
+        vaciarConsola();
+    if (cache_pag.volcado_pendiente)
+        volcarCache(NULL);
+
     nserv = leer_registro(0);
     if (nserv < NSERVICIOS)
         res = (tabla_servicios[nserv].fservicio)();
@@ -395,9 +854,12 @@ static void tratar_llamsis() {
  */
 static void int_sw() {
 
-    printk("-> TRATANDO INT. SW\n");
+    if (consola.vaciado_pendiente)
+        vaciarConsola();
 
     if (p_proc_int != p_proc_actual->id)return;
+    p_proc_int = -1;
+    printk("-> TRATANDO INT. SW\n");
     BCP *proceso_listo = lista_listos.primero;
 
     int int_level = fijar_nivel_int(NIVEL_3);
@@ -412,6 +874,29 @@ static void int_sw() {
     return;
 }
 
+/*
+ *
+ * Funcion auxiliar que inicia los campos comunes del BCP de un proceso
+ * o hilo recien creado y lo inserta en la cola de listos.
+ *
+ */
+static void iniciar_BCP(BCP *p_proc, int id, int grupo) {
+    p_proc->id = id;
+    p_proc->grupo = grupo;
+    p_proc->estado = LISTO;
+    p_proc->min_lectura = 0;
+    p_proc->cola_espera = NULL;
+    p_proc->hilo_esperado = -1;
+    p_proc->valor_hilo = 0;
+    p_proc->futex_dir = NULL;
+    p_proc->no_bloqueante = 0;
+    p_proc->salida_buf = NULL;
+    p_proc->salida_lon = NULL;
+    p_proc->plazo = 0;
+    /* lo inserta al final de cola de listos */
+    insertar_ultimo(&lista_listos, p_proc);
+}
+
 /*
  *
  * Funcion auxiliar que crea un proceso reservando sus recursos.
@@ -430,30 +915,28 @@ static int crear_tarea(char *prog) {
 
     /* A rellenar el BCP ... */
     p_proc = &(tabla_procs[proc]);
+    if (iniciarDescriptores(p_proc) < 0)
+        return -1;
+    p_proc->recursos = crearRecursos(p_proc_actual != NULL ?
+                                     p_proc_actual->recursos : NULL);
+    if (p_proc->recursos == NULL)
+        return -1;
 
     /* crea la imagen de memoria leyendo ejecutable */
     imagen = crear_imagen(prog, &pc_inicial);
     if (imagen) {
+        num_imagenes++;
         p_proc->info_mem = imagen;
         p_proc->pila = crear_pila(TAM_PILA);
         fijar_contexto_ini(p_proc->info_mem, p_proc->pila, TAM_PILA,
                            pc_inicial,
                            &(p_proc->contexto_regs));
-        p_proc->id = proc;
-        p_proc->estado = LISTO;
-        p_proc->nMutex = 0;
-        p_proc->mutexBlock = 0;
-        p_proc->readBlock = 0;
-        p_proc->mutex_id = -1;
-        int i;
-        for (i = 0; i < NUM_MUT_PROC; i++) {
-            p_proc->mutexList[i] = -1;
-        }
-        /* lo inserta al final de cola de listos */
-        insertar_ultimo(&lista_listos, p_proc);
+        iniciar_BCP(p_proc, proc, cont_grupos++);
         error = 0;
-    } else
+    } else {
+        soltarRecursos(p_proc->recursos);
         error = -1; /* fallo al crear imagen */
+    }
 
     return error;
 }
@@ -489,11 +972,50 @@ int sis_escribir() {
 
     texto = (char *) leer_registro(1);
     longi = (unsigned int) leer_registro(2);
+    if (longi > MAX_ESCRITURA)
+        return -1;
 
-    escribir_ker(texto, longi);
+    int int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+    escribirConsola(texto, longi);
+    memAccess = 0;
     return 0;
 }
 
+/*
+ * Tratamiento de llamada al sistema escribirv. Escribe los n fragmentos
+ * seguidos en una sola llamada, sin que se intercale la salida de otros
+ * procesos. Devuelve el total de caracteres escritos, o -1 sin escribir
+ * nada si hay mas de MAX_FRAGMENTOS o suman mas de MAX_ESCRITURA.
+ */
+int sis_escribirv() {
+    struct fragmento *fragmentos = (struct fragmento *) leer_registro(1);
+    int n = (int) leer_registro(2);
+    unsigned int total = 0;
+    int i;
+
+    if (fragmentos == NULL || n < 0 || n > MAX_FRAGMENTOS)
+        return -1;
+
+    int int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+
+    /* se comprueba cada fragmento para que la suma no desborde */
+    for (i = 0; i < n; i++) {
+        if (fragmentos[i].longi > MAX_ESCRITURA - total) {
+            memAccess = 0;
+            return -1;
+        }
+        total += fragmentos[i].longi;
+    }
+    for (i = 0; i < n; i++)
+        escribirConsola(fragmentos[i].texto, fragmentos[i].longi);
+    memAccess = 0;
+    return total;
+}
+
 /*
  * Tratamiento de llamada al sistema terminar_proceso. Llama a la
  * funcion auxiliar liberar_proceso
@@ -502,6 +1024,7 @@ int sis_terminar_proceso() {
 
     printk("-> FIN PROCESO %d\n", p_proc_actual->id);
 
+    p_proc_actual->valor_hilo = 0;
     liberar_proceso();
 
     return 0; /* no deber�a llegar aqui */
@@ -516,11 +1039,14 @@ int sis_dormir() {
     unsigned int seg = (unsigned int) leer_registro(1);
     //printf("******************** Dormir: (%d) segundos \n", seg);
 
+    if (seg == 0)
+        return 0;
     p_proc_actual->estado = BLOQUEADO;
-    p_proc_actual->nSegBlocked = seg;
-    p_proc_actual->startBlockAt = int_clock_counter;
 
-    anadirProcesoAListaBloqueados(p_proc_actual);
+    int int_level = fijar_nivel_int(NIVEL_3);
+    eliminar_elem(&lista_listos, p_proc_actual);
+    armarTemporizador(p_proc_actual, int_clock_counter + seg * TICK);
+    fijar_nivel_int(int_level);
 
     BCP *p_proc_blocked = p_proc_actual;
     p_proc_actual = planificador();
@@ -552,369 +1078,2731 @@ int sis_crear_mutex() {
     char *nombre = (char *) leer_registro(1);
     int tipo = (int) leer_registro(2);
 
-    printf("\n\n******************** PROCEDEMOS A CREAR EL MUTEX %s DEL TIPO %d\n", nombre, tipo);
+    return crearObjeto(nombre, CLASE_MUTEX, tipo);
+}
 
-    if (!verificaCondiciones(nombre)) {
-        printf("******************** ERROR: NO SE HA VERIFICADO LAS CONDICIONES NECESARIAS\n");
-        return -1;
-    }
+int sis_abrir_mutex() {
 
-    printf("******************** HAY %d mutex en el sistema\n", cont_mutex);
+    char *nombre = (char *) leer_registro(1);
+    return abrirObjeto(nombre, CLASE_MUTEX);
+}
 
-    while (cont_mutex >= NUM_MUT) {
-        // printf("******************** NUMERO MAXIMO DE MUTEX EN EL SISTEMA EXCEDIDO\n");
+int sis_lock() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
 
-        p_proc_actual->estado = BLOQUEADO;
-        p_proc_actual->mutexBlock = 1;
-        anadirProcesoAListaBloqueados(p_proc_actual);
+    return lockMutex(descriptor, 0, true);
+}
 
-        printf("******************** CAMBIAMOS CONTEXTO DEL PROC %d\n", p_proc_actual->id);
-        BCP *p_proc_blocked = p_proc_actual;
-        p_proc_actual = planificador();
-        cambio_contexto(&(p_proc_blocked->contexto_regs), &(p_proc_actual->contexto_regs));
+/*
+ * Tratamiento de llamada al sistema trylock. Como lock, pero sin
+ * bloquearse: devuelve 1 si el mutex lo tiene otro proceso.
+ */
+int sis_trylock() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
 
-        printf("******************** VOLVEMOS A VERIFICAR NOMBRE %s DEL PROC %d\n", nombre, p_proc_actual->id);
-        if (!verificaCondiciones(nombre))return -1;
-    }
-    printf("******************** NUMERO MAXIMO DE MUTEX EN EL SISTEMA OK\n");
+    return lockMutex(descriptor, 0, false);
+}
 
-    crearMutex(nombre, tipo);
-    int descriptor = getDescriptor();
-    printf("******************** ASIGNAMOS DESCRIPTOR %d al proceso %d\n", descriptor, p_proc_actual->id);
-    p_proc_actual->mutexList[descriptor] = cont_mutex_index++;
-    cont_mutex++;
+/*
+ * Tratamiento de llamada al sistema lock_timeout. Como lock, pero espera
+ * como mucho ms milisegundos; si vence el plazo sin obtener el mutex
+ * sale de su cola de espera y devuelve 1.
+ */
+int sis_lock_timeout() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    unsigned int ms = (unsigned int) leer_registro(2);
+
+    if (ms == 0)
+        return lockMutex(descriptor, 0, false);
+    return lockMutex(descriptor, plazoMs(ms), true);
+}
 
-    printf("******************** FIN CREAR MUTEX\n\n");
-    return p_proc_actual->nMutex++;
 
+int sis_unlock() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    mutex *mutex1 = objetoDescriptor(descriptor, CLASE_MUTEX);
 
+    if (mutex1 == NULL || mutex1->proceso_bloqueado != p_proc_actual->id)
+        return -1;
+    if (--mutex1->num_bloqueos > 0)
+        return 0; /* recursivo: quedan locks del propietario */
+    liberarMutex(mutex1);
+    return 0;
 }
 
-int sis_abrir_mutex() {
 
+int sis_cerrar_mutex() {
+
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    return cerrarDescriptor(descriptor, CLASE_MUTEX);
+}
+
+/*
+ * Tratamiento de llamada al sistema crear_sem. Crea un semaforo con
+ * nombre y valor inicial dados y devuelve su descriptor.
+ */
+int sis_crear_sem() {
     char *nombre = (char *) leer_registro(1);
-    printf("\n\n------------- EMPEZAMOS A ABRIR MUTEX %s\n", nombre);
-    if (p_proc_actual->nMutex >= NUM_MUT_PROC)return -1;
-    printf("------------- buscamos id del mutex\n");
-    int mutex_id = getMutexId(nombre);
-    if (mutex_id == -1) {
-        printf("------------- ERROR: id no encontrado\n");
+    int valor = (int) leer_registro(2);
+    int descriptor;
+
+    if (valor < 0)
         return -1;
-    }
-    printf("------------- encontrado id: %d\n", mutex_id);
-    int descriptor = getDescriptor();
-    printf("------------- asignamos descriptor %d a proceso %d\n", descriptor, p_proc_actual->id);
-    p_proc_actual->mutexList[descriptor] = mutex_id;
-    mutex *mutex1 = getMutex(&lista_mutex, mutex_id);
-    mutex1->num_procesos++;
-    printf("******************** FIN ABRIR MUTEX\n\n");
-    return p_proc_actual->nMutex++;
+    descriptor = crearObjeto(nombre, CLASE_SEMAFORO, 0);
+    if (descriptor >= 0)
+        getMutex(p_proc_actual->mutexList[descriptor])->valor = valor;
+    return descriptor;
 }
 
-int sis_lock() {
+int sis_abrir_sem() {
+    char *nombre = (char *) leer_registro(1);
+
+    return abrirObjeto(nombre, CLASE_SEMAFORO);
+}
+
+/*
+ * Tratamiento de llamada al sistema sem_esperar. Si el contador es cero
+ * bloquea al proceso hasta que un sem_senalar le ceda la unidad.
+ */
+int sis_sem_esperar() {
     unsigned int descriptor = (unsigned int) leer_registro(1);
-    int mutex_id;
-    printf("\n\n-------> EMPEZAMOS A BLOQUEAR MUTEX %d\n", descriptor);
-    if (descriptor > NUM_MUT_PROC - 1
-        || (mutex_id = p_proc_actual->mutexList[descriptor]) == -1)
+    mutex *sem = objetoDescriptor(descriptor, CLASE_SEMAFORO);
+
+    if (sem == NULL)
         return -1;
-    printf("-------> OBTENEMOS EL MUTEX CON INDEX %d\n", mutex_id);
-    mutex *mutex1 = getMutex(&lista_mutex, mutex_id);
+    if (sem->valor > 0)
+        sem->valor--;
+    else
+        esperarMutex(sem);
+    return 0;
+}
 
-    while (mutex1->index != -1 && mutex1->proceso_bloqueado != p_proc_actual->id
-           && mutex1->proceso_bloqueado != -1) {
-        // printf("-------> EL MUTEX %d ESTA CERRADO, BLOQUEAMOS PROCESO %d\n", p_proc_actual->id);
-        p_proc_actual->estado = BLOQUEADO;
-        p_proc_actual->mutex_id = mutex_id;
-        // printf("-------> BLOQUEAMOS\n");
-        anadirProcesoAListaBloqueados(p_proc_actual);
-        // printf("-------> CAMBIO DE CONTEXTO\n");
-        BCP *p_proc_blocked = p_proc_actual;
-        p_proc_actual = planificador();
-        cambio_contexto(&(p_proc_blocked->contexto_regs), &(p_proc_actual->contexto_regs));
-    }
-    printf("-------> EL MUTEX %d NO ESTA CERRADO\n", mutex_id);
+/*
+ * Tratamiento de llamada al sistema sem_senalar. Si hay procesos
+ * bloqueados la unidad pasa directamente al primero; si no, incrementa
+ * el contador.
+ */
+int sis_sem_senalar() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    mutex *sem = objetoDescriptor(descriptor, CLASE_SEMAFORO);
 
-    printf("-------> COMPROBAMOS CONDICIONES\n");
-    if (mutex1->index != -1 && mutex1->tipo == NO_RECURSIVO && mutex1->num_procesos == 1) {
-        printf("-------> ERROR: MUTEX NO RECURSIVO CON NUMERO DE PROCESOS %d\n", mutex1->num_procesos);
+    if (sem == NULL)
         return -1;
-    }
-    printf("Mutex %d tiene asignado %d", mutex1->index, mutex1->proceso_bloqueado);
-    printf("asignamos mutex %d a proceso %d", mutex_id, p_proc_actual->id);
-    mutex1->proceso_bloqueado = p_proc_actual->id;
-    mutex1->num_procesos++;
+    if (despertarPrimero(sem) == NULL)
+        sem->valor++;
     return 0;
 }
 
+int sis_cerrar_sem() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
 
-int sis_unlock() {
+    return cerrarDescriptor(descriptor, CLASE_SEMAFORO);
+}
 
-    unsigned int descriptor = (unsigned int) leer_registro(1);
-    int mutex_id;
-    printf("\n\n-------> EMPEZAMOS A DESBLOQUEAR MUTEX %d\n", descriptor);
-    if (descriptor > NUM_MUT_PROC - 1
-        || (mutex_id = p_proc_actual->mutexList[descriptor]) == -1)
-        return -1;
-    printf("-------> OBTENEMOS EL MUTEX CON INDEX %d\n", mutex_id);
-    mutex *mutex1 = getMutex(&lista_mutex, mutex_id);
-    if (mutex1->index == -1 || mutex1->proceso_bloqueado != p_proc_actual->id)
-        return -1;
-    mutex1->num_procesos--;
-    if (mutex1->num_procesos != 0) {
-        printf("-------> MUTEX RECURSIVO BLOQUEADO POR %d PROCESOS MAS\n", mutex1->num_procesos);
-        return 0;
-    }
-    printf("-------> MUTEX DESBLOQUEADO\n");
-    mutex1->proceso_bloqueado = -1;
+int sis_crear_cond() {
+    char *nombre = (char *) leer_registro(1);
 
-    BCP *proceso_bloqueado = lista_blocked.primero;
-    bool encontrado = false;
+    return crearObjeto(nombre, CLASE_CONDICION, 0);
+}
 
-    while (proceso_bloqueado != NULL && !encontrado) {
-        BCP *proceso_siguiente = proceso_bloqueado->siguiente;
-        if (proceso_bloqueado->estado == BLOQUEADO
-            && proceso_bloqueado->mutex_id == mutex_id) {
-            proceso_bloqueado->estado = LISTO;
-            proceso_bloqueado->mutex_id = -1;
-            proceso_bloqueado->mutexBlock = 0;
+int sis_abrir_cond() {
+    char *nombre = (char *) leer_registro(1);
 
-            eliminarProcesoListaBloqueados(proceso_bloqueado);
+    return abrirObjeto(nombre, CLASE_CONDICION);
+}
 
-            encontrado = true;
-        }
-        proceso_bloqueado = proceso_siguiente;
-    }
+/*
+ * Tratamiento de llamada al sistema cond_esperar. El proceso, que debe
+ * tener cerrado el mutex, lo abre y se bloquea en la condicion sin que
+ * nadie pueda ejecutar entre medias. Al despertar vuelve a cerrar el
+ * mutex con la misma profundidad de bloqueo que tenia.
+ */
+int sis_cond_esperar() {
+    unsigned int desc_cond = (unsigned int) leer_registro(1);
+    unsigned int desc_mutex = (unsigned int) leer_registro(2);
+    mutex *cond = objetoDescriptor(desc_cond, CLASE_CONDICION);
+    mutex *mutex1 = objetoDescriptor(desc_mutex, CLASE_MUTEX);
+    int num_bloqueos;
+
+    if (cond == NULL || mutex1 == NULL
+        || mutex1->proceso_bloqueado != p_proc_actual->id)
+        return -1;
+
+    num_bloqueos = mutex1->num_bloqueos;
+    liberarMutex(mutex1);
+    esperarMutex(cond);
+    adquirirMutex(mutex1);
+    mutex1->num_bloqueos = num_bloqueos;
     return 0;
 }
 
+/*
+ * Tratamiento de llamada al sistema cond_senalar. Despierta al primer
+ * proceso bloqueado en la condicion, si lo hay.
+ */
+int sis_cond_senalar() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    mutex *cond = objetoDescriptor(descriptor, CLASE_CONDICION);
 
-int sis_cerrar_mutex() {
+    if (cond == NULL)
+        return -1;
+    despertarPrimero(cond);
+    return 0;
+}
 
+/*
+ * Tratamiento de llamada al sistema cond_difundir. Despierta a todos los
+ * procesos bloqueados en la condicion.
+ */
+int sis_cond_difundir() {
     unsigned int descriptor = (unsigned int) leer_registro(1);
-    int mutex_id;
-    printf("\n\n::::::::::::EMPEZAMOS A CERRAR MUTEX %d\n", descriptor);
-    if (descriptor > NUM_MUT_PROC - 1
-        || (mutex_id = p_proc_actual->mutexList[descriptor]) == -1)
+    mutex *cond = objetoDescriptor(descriptor, CLASE_CONDICION);
+
+    if (cond == NULL)
         return -1;
-    printf("\n\n::::::::::::PROCEDEMOS A ELEMINAR MUTEX %d PROCESO %d\n", mutex_id, p_proc_actual->id);
-    mutex *mutex1 = getMutex(&lista_mutex, mutex_id);
-    if (mutex1->index == -1)
+    despertarTodos(&(cond->esperando));
+    return 0;
+}
+
+int sis_cerrar_cond() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+
+    return cerrarDescriptor(descriptor, CLASE_CONDICION);
+}
+
+
+int sis_crear_lectesc() {
+    char *nombre = (char *) leer_registro(1);
+    int politica = (int) leer_registro(2);
+
+    if (politica != LECTESC_PREF_ESCRITOR && politica != LECTESC_EQUITATIVO)
         return -1;
-    mutex1->num_procesos--;
-    p_proc_actual->nMutex--;
-    p_proc_actual->mutexList[descriptor] = -1;
+    return crearObjeto(nombre, CLASE_LECTESC, politica);
+}
 
-    if (mutex1->proceso_bloqueado == p_proc_actual->id) {
-        mutex1->proceso_bloqueado = -1;
-        mutex1->num_procesos = 0;
-    }
+int sis_abrir_lectesc() {
+    char *nombre = (char *) leer_registro(1);
 
-    printf("::::::::::::BUSCAMOS PROCESOS BLOQUEADOS\n");
-    BCP *proceso_bloqueado = lista_blocked.primero;
-    bool encontrado = false;
-    while (proceso_bloqueado != NULL && !encontrado) {
-        printf("::::::::::::BUSCAMOS PROCESO BLOQUEADO POR MUTEX\n");
-        BCP *proceso_siguiente = proceso_bloqueado->siguiente;
-        if (proceso_bloqueado->mutex_id == mutex_id) {
-            printf("::::::::::::PROCESO ENCONTRADO: %d\n", proceso_bloqueado->id);
-            proceso_bloqueado->estado = LISTO;
-            proceso_bloqueado->mutex_id = -1;
-            eliminarProcesoListaBloqueados(proceso_bloqueado);
-            encontrado = true;
-        }
-        proceso_bloqueado = proceso_siguiente;
-    }
-    if (mutex1->num_procesos > 0)
-        return 0;
-    printf("::::::::::::NO HAY MAS PROCESOS\n");
-    eliminar_mutex(&lista_mutex, mutex_id);
-    strcpy(mutex1->nombre, "");
-    cont_mutex--;
+    return abrirObjeto(nombre, CLASE_LECTESC);
+}
 
+/*
+ * Tratamiento de llamada al sistema lock_lectura. El proceso entra si no
+ * hay escritor ni escritores esperando; si no, se bloquea hasta que se
+ * le conceda el lock al liberarse el cerrojo. Un proceso que ya tiene un
+ * lock de lectura entra siempre, para no bloquearse tras un escritor
+ * que espera por el.
+ */
+int sis_lock_lectura() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    mutex *cerrojo = objetoDescriptor(descriptor, CLASE_LECTESC);
 
-    proceso_bloqueado = lista_blocked.primero;
-    while (proceso_bloqueado != NULL) {
-        BCP *proceso_siguiente = proceso_bloqueado->siguiente;
-        if (proceso_bloqueado->estado == BLOQUEADO
-            && proceso_bloqueado->mutexBlock == 1) {
-            proceso_bloqueado->estado = LISTO;
-            proceso_bloqueado->mutexBlock = 0;
-            eliminarProcesoListaBloqueados(proceso_bloqueado);
-            break;
-        }
-        proceso_bloqueado = proceso_siguiente;
-    }
+    if (cerrojo == NULL || cerrojo->proceso_bloqueado == p_proc_actual->id)
+        return -1;
+    if (p_proc_actual->lecturas[descriptor] > 0
+        || (cerrojo->proceso_bloqueado == -1 && cerrojo->esperando.primero == NULL))
+        cerrojo->num_lectores++;
+    else
+        esperarEnCola(&(cerrojo->esperando_lect), 0);
+    p_proc_actual->lecturas[descriptor]++;
+    return 0;
+}
+
+/*
+ * Tratamiento de llamada al sistema lock_escritura. El proceso entra si
+ * el cerrojo esta libre y nadie espera; si no, se bloquea hasta que se
+ * le ceda. Un proceso con lock de lectura no puede pedirlo.
+ */
+int sis_lock_escritura() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    mutex *cerrojo = objetoDescriptor(descriptor, CLASE_LECTESC);
 
-    printf("\n\n::::::::::::MUTEX ELIMINADO %d\n", descriptor);
+    if (cerrojo == NULL || cerrojo->proceso_bloqueado == p_proc_actual->id
+        || p_proc_actual->lecturas[descriptor] > 0)
+        return -1;
+    if (cerrojo->proceso_bloqueado == -1 && cerrojo->num_lectores == 0
+        && cerrojo->esperando.primero == NULL)
+        cerrojo->proceso_bloqueado = p_proc_actual->id;
+    else
+        esperarMutex(cerrojo);
     return 0;
 }
 
+/*
+ * Tratamiento de llamada al sistema unlock_lectesc. Suelta el lock de
+ * escritura o uno de lectura, el que tenga el proceso.
+ */
+int sis_unlock_lectesc() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    mutex *cerrojo = objetoDescriptor(descriptor, CLASE_LECTESC);
 
-int sis_leer_caracter() {
+    if (cerrojo == NULL)
+        return -1;
+    if (cerrojo->proceso_bloqueado == p_proc_actual->id)
+        liberarEscritura(cerrojo);
+    else if (p_proc_actual->lecturas[descriptor] > 0) {
+        p_proc_actual->lecturas[descriptor]--;
+        liberarLectura(cerrojo);
+    } else
+        return -1;
+    return 0;
+}
 
-    printf("\n\nCOMIENZA LEER CARACTER\n");
-    int int_level = fijar_nivel_int(NIVEL_2);
+int sis_cerrar_lectesc() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
 
-    while (size_buffer == 0) {
-        //printf("BUFFER VACIO\n");
-        p_proc_actual->estado = BLOQUEADO;
-        p_proc_actual->readBlock = 1;
+    return cerrarDescriptor(descriptor, CLASE_LECTESC);
+}
 
-        int int_level_2 = fijar_nivel_int(NIVEL_3);
-        eliminar_elem(&lista_listos, p_proc_actual);
-        insertar_ultimo(&lista_blocked, p_proc_actual);
-        fijar_nivel_int(int_level_2);
 
-        BCP *p_proc_blocked = p_proc_actual;
-        p_proc_actual = planificador();
-        cambio_contexto(&(p_proc_blocked->contexto_regs), &(p_proc_actual->contexto_regs));
-    }
+/*
+ * Tratamiento de llamada al sistema crear_barrera. Crea una barrera con
+ * nombre para n participantes y devuelve su descriptor.
+ */
+int sis_crear_barrera() {
+    char *nombre = (char *) leer_registro(1);
+    int n = (int) leer_registro(2);
+    int descriptor;
 
-    printf("BUFFER NO VACIO\n");
-    char primer_car = buffer[0];
-    printf("LEIDO PRIMER CARACTER\n");
-    size_buffer--;
-    int i;
-    for (i = 0; i < size_buffer; i++) {
-        buffer[i] = buffer[i + 1];
+    if (n <= 0)
+        return -1;
+    descriptor = crearObjeto(nombre, CLASE_BARRERA, n);
+    if (descriptor >= 0)
+        getMutex(p_proc_actual->mutexList[descriptor])->valor = n;
+    return descriptor;
+}
+
+int sis_abrir_barrera() {
+    char *nombre = (char *) leer_registro(1);
+
+    return abrirObjeto(nombre, CLASE_BARRERA);
+}
+
+/*
+ * Tratamiento de llamada al sistema barrera_esperar. Bloquea al proceso
+ * hasta que lleguen todos los participantes. El ultimo en llegar los
+ * desbloquea a todos, deja la barrera lista para la siguiente fase y
+ * recibe 1; el resto recibe 0. El descriptor queda marcado como de un
+ * participante, que deja de contarse cuando lo cierra.
+ */
+int sis_barrera_esperar() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    mutex *barrera = objetoDescriptor(descriptor, CLASE_BARRERA);
+
+    if (barrera == NULL)
+        return -1;
+    p_proc_actual->lecturas[descriptor] = 1;
+    if (--barrera->valor > 0) {
+        esperarMutex(barrera);
+        return 0;
     }
-    fijar_nivel_int(int_level);
+    barrera->valor = barrera->tipo;
+    despertarTodos(&(barrera->esperando));
+    return 1;
+}
+
+int sis_cerrar_barrera() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
 
-    return primer_car;
+    return cerrarDescriptor(descriptor, CLASE_BARRERA);
 }
 
-/******************************************
- * ****************************************
- * ******** Funciones auxiliares **********
- * ****************************************
- * ****************************************
+/*
+ * Tratamiento de llamada al sistema crear_cuenta. Crea una cuenta atras
+ * con nombre que empieza en n y devuelve su descriptor.
  */
+int sis_crear_cuenta() {
+    char *nombre = (char *) leer_registro(1);
+    int n = (int) leer_registro(2);
+    int descriptor;
 
-void anadirProcesoAListaBloqueados(BCP *proc) {
-    int int_level = fijar_nivel_int(NIVEL_3);
-    eliminar_elem(&lista_listos, proc);
-    insertar_ultimo(&lista_blocked, proc);
-    fijar_nivel_int(int_level);
+    if (n < 0)
+        return -1;
+    descriptor = crearObjeto(nombre, CLASE_CUENTA, 0);
+    if (descriptor >= 0)
+        getMutex(p_proc_actual->mutexList[descriptor])->valor = n;
+    return descriptor;
 }
 
-void eliminarProcesoListaBloqueados(BCP *proceso_bloqueado) {
-    int int_level = fijar_nivel_int(NIVEL_3);
-    eliminar_elem(&lista_blocked, proceso_bloqueado);
-    insertar_ultimo(&lista_listos, proceso_bloqueado);
-    fijar_nivel_int(int_level);
+int sis_abrir_cuenta() {
+    char *nombre = (char *) leer_registro(1);
+
+    return abrirObjeto(nombre, CLASE_CUENTA);
 }
 
-int getMutexId(const char *nombre) {
-    mutex *mutex_primero = lista_mutex.primero;
-    int mutex_id = -1;
-    while (mutex_primero != NULL) {
-        if (strcmp(mutex_primero->nombre, nombre) == 0) {
-            mutex_id = mutex_primero->index;
-        }
-        mutex *mutex_next = mutex_primero->siguiente;
-        mutex_primero = mutex_next;
-    }
-    return mutex_id;
+/*
+ * Tratamiento de llamada al sistema cuenta_descontar. Decrementa la
+ * cuenta y, al llegar a cero, desbloquea a todos los que esperan. Una
+ * cuenta a cero no vuelve a cambiar.
+ */
+int sis_cuenta_descontar() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    mutex *cuenta = objetoDescriptor(descriptor, CLASE_CUENTA);
+
+    if (cuenta == NULL)
+        return -1;
+    if (cuenta->valor > 0 && --cuenta->valor == 0)
+        despertarTodos(&(cuenta->esperando));
+    return 0;
 }
 
-mutex *getMutex(lista_Mutex *lista, int mutex_id) {
-    mutex *mutex_it = lista->primero;
-    mutex *mutex_it_return = malloc(sizeof(mutex));
-    while (mutex_it != NULL) {
-        if (mutex_it->index == mutex_id) {
-            mutex_it_return = mutex_it;
-            return mutex_it_return;
-        }
-        mutex_it = mutex_it->siguiente;
-    }
-    mutex_it_return->index = -1;
-    strcpy(mutex_it_return->nombre, "Failed");
-    return mutex_it_return;
+/*
+ * Tratamiento de llamada al sistema cuenta_esperar. Bloquea al proceso
+ * hasta que la cuenta llegue a cero.
+ */
+int sis_cuenta_esperar() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    mutex *cuenta = objetoDescriptor(descriptor, CLASE_CUENTA);
 
+    if (cuenta == NULL)
+        return -1;
+    if (cuenta->valor > 0)
+        esperarMutex(cuenta);
+    return 0;
 }
 
-int getDescriptor() {
-    int i;
-    for (i = 0; i < NUM_MUT_PROC; ++i) {
-        if (p_proc_actual->mutexList[i] == -1) {
-            return i;
-        }
-    }
-    return -1;
+int sis_cerrar_cuenta() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+
+    return cerrarDescriptor(descriptor, CLASE_CUENTA);
 }
 
-bool verificaCondiciones(const char *nombre) {
+/*
+ *
+ * Colas de mensajes
+ *	iniciarColaMensajes esperarColaMensajes meterMensaje sacarMensaje
+ *
+ * Cada cola guarda como mucho max_mensajes de hasta tam_max bytes. Los
+ * mensajes se entregan por orden de prioridad y, dentro de la misma, por
+ * orden de llegada. Los emisores esperan en esperando cuando la cola esta
+ * llena y los receptores en esperando_lect cuando esta vacia.
+ */
 
-    return strlen(nombre) <= MAX_NOM_MUT
-           && p_proc_actual->nMutex <= NUM_MUT_PROC
-           && !nombreMutexRepetido(nombre);
+/*
+ * Reserva una cola vacia con sus huecos en un unico bloque de memoria
+ */
+static cola_mensajes *iniciarColaMensajes(int max_mensajes, int tam_max) {
+    cola_mensajes *c;
+    int i;
+
+    c = malloc(sizeof(cola_mensajes) + max_mensajes * sizeof(cab_mensaje)
+               + (size_t) max_mensajes * tam_max);
+    if (c == NULL)
+        return NULL;
+    c->tam_max = tam_max;
+    c->max_mensajes = max_mensajes;
+    c->num_mensajes = 0;
+    c->cab = (cab_mensaje *) (c + 1);
+    c->datos = (char *) (c->cab + max_mensajes);
+    for (i = 0; i < max_mensajes; i++)
+        c->cab[i].siguiente = i + 1 < max_mensajes ? i + 1 : -1;
+    c->libres = 0;
+    for (i = 0; i < NUM_PRIO_COLA; i++)
+        c->primero[i] = c->ultimo[i] = -1;
+    c->carriles = 0;
+    return c;
 }
 
-bool nombreMutexRepetido(const char *nombre) {
-    mutex *mutex_primero = lista_mutex.primero;
-    bool repetido = false;
-    while (mutex_primero != NULL && !repetido) {
-        // printf("******************** NOMBRE %s......\n", mutex_primero->nombre);
-        if (strcmp(mutex_primero->nombre, nombre) == 0) {
-            repetido = true;
-        }
-        mutex *mutex_next = mutex_primero->siguiente;
-        mutex_primero = mutex_next;
+/*
+ * Bloquea al proceso mientras la cola este llena (emisor) o vacia
+ * (receptor). Con ms 0 no espera y con ms negativo espera sin limite.
+ * Devuelve -1 si vence el plazo.
+ */
+static int esperarColaMensajes(mutex *cola, bool emisor, int ms) {
+    cola_mensajes *c = cola->mensajes;
+    int plazo = ms > 0 ? plazoMs(ms) : 0;
+
+    while (emisor ? c->num_mensajes == c->max_mensajes : c->num_mensajes == 0) {
+        if (ms == 0 || (plazo != 0 && int_clock_counter >= plazo))
+            return -1;
+        esperarEnCola(emisor ? &cola->esperando : &cola->esperando_lect, plazo);
     }
-    //printf("******************** ........ EL NOMBRE ESTA REPETIDO  %s\n", repetido ? "true" : "false");
-    return repetido;
+    return 0;
 }
 
-void insertar_mutex(lista_Mutex *lista, mutex *pMutex) {
-    printf("\t INSERTAMOS MUTEX -> %d\n", pMutex->index);
-    if (lista->primero == NULL)
-        lista->primero = pMutex;
+/*
+ * Copia el mensaje en un hueco libre y lo pone al final de su carril.
+ * Debe haber hueco y el llamante debe permitir el acceso a memoria. El
+ * hueco se saca de la lista de libres despues de copiar, para que no se
+ * pierda si la copia falla y termina el proceso.
+ */
+static void meterMensaje(cola_mensajes *c, char *msg, int lon, int prioridad) {
+    int hueco = c->libres;
+
+    memcpy(c->datos + (size_t) hueco * c->tam_max, msg, lon);
+    c->libres = c->cab[hueco].siguiente;
+    c->cab[hueco].siguiente = -1;
+    c->cab[hueco].lon = lon;
+    c->cab[hueco].prioridad = prioridad;
+    if (c->ultimo[prioridad] < 0)
+        c->primero[prioridad] = hueco;
     else
-        lista->ultimo->siguiente = pMutex;
-    lista->ultimo = pMutex;
-    pMutex->siguiente = NULL;
+        c->cab[c->ultimo[prioridad]].siguiente = hueco;
+    c->ultimo[prioridad] = hueco;
+    c->carriles |= 1u << prioridad;
+    c->num_mensajes++;
 }
 
-void eliminar_mutex(lista_Mutex *lista, int mutex_id) {
-    printf("\t ELIMINAMOS MUTEX -> %d\n", mutex_id);
-    mutex *mutex_it = lista->primero;
+/*
+ * Saca el primer mensaje del carril mas prioritario y lo copia en buf.
+ * Devuelve su longitud, o -1 dejandolo en la cola si no cabe en tam
+ * bytes. Debe haber mensajes y el llamante debe permitir el acceso a
+ * memoria.
+ */
+static int sacarMensaje(cola_mensajes *c, char *buf, int tam, int *prioridad) {
+    int carril = 31 - __builtin_clz(c->carriles);
+    int hueco = c->primero[carril];
+    int lon = c->cab[hueco].lon;
 
-    if (mutex_it->index == mutex_id)
-        eliminar_primero_mutex(lista);
-    else {
-        for (; ((mutex_it) && (mutex_it->siguiente->index != mutex_id));
-               mutex_it = mutex_it->siguiente);
-        if (mutex_it) {
-            if (lista->ultimo == mutex_it->siguiente)
-                lista->ultimo = mutex_it;
-            mutex_it->siguiente = mutex_it->siguiente->siguiente;
-        }
+    if (lon > tam)
+        return -1;
+    memcpy(buf, c->datos + (size_t) hueco * c->tam_max, lon);
+    *prioridad = carril;
+    c->primero[carril] = c->cab[hueco].siguiente;
+    if (c->primero[carril] < 0) {
+        c->ultimo[carril] = -1;
+        c->carriles &= ~(1u << carril);
     }
+    c->cab[hueco].siguiente = c->libres;
+    c->libres = hueco;
+    c->num_mensajes--;
+    return lon;
 }
 
-void eliminar_primero_mutex(lista_Mutex *lista) {
-
-    if (lista->ultimo == lista->primero)
-        lista->ultimo = NULL;
-    lista->primero = lista->primero->siguiente;
-}
+/*
+ * Tratamiento de llamada al sistema crear_cola. Crea una cola de mensajes
+ * con nombre para max_mensajes mensajes de hasta tam_max bytes y devuelve
+ * su descriptor.
+ */
+int sis_crear_cola() {
+    char *nombre = (char *) leer_registro(1);
+    int max_mensajes = (int) leer_registro(2);
+    int tam_max = (int) leer_registro(3);
+    cola_mensajes *c;
+    int descriptor;
 
-void crearMutex(char *nombre, int tipo) {
-    printf("******************** CREAMOS MUTEX\n");
-    mutex *nuevo_mutex = malloc(sizeof(mutex));
-    nuevo_mutex->index = cont_mutex_index;
-    printf("******************** init mutex con index %d\n", nuevo_mutex->index);
-    printf("******************** init mutex con nombre %s\n", nombre);
+    if (max_mensajes <= 0 || tam_max <= 0)
+        return -1;
+    if ((c = iniciarColaMensajes(max_mensajes, tam_max)) == NULL)
+        return -1;
+    descriptor = crearObjeto(nombre, CLASE_COLA, 0);
+    if (descriptor < 0) {
+        free(c);
+        return -1;
+    }
+    getMutex(p_proc_actual->mutexList[descriptor])->mensajes = c;
+    return descriptor;
+}
+
+int sis_abrir_cola() {
+    char *nombre = (char *) leer_registro(1);
+
+    return abrirObjeto(nombre, CLASE_COLA);
+}
+
+/*
+ * Tratamiento de llamada al sistema enviar. Pone en la cola un mensaje de
+ * lon bytes con la prioridad indicada, esperando como mucho ms
+ * milisegundos (sin limite si es negativo) a que haya hueco.
+ */
+int sis_enviar() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    char *msg = (char *) leer_registro(2);
+    int lon = (int) leer_registro(3);
+    int prioridad = (int) leer_registro(4);
+    int ms = (int) leer_registro(5);
+    mutex *cola = objetoDescriptor(descriptor, CLASE_COLA);
+
+    if (cola == NULL || msg == NULL || lon < 0 || lon > cola->mensajes->tam_max
+        || prioridad < 0 || prioridad >= NUM_PRIO_COLA)
+        return -1;
+    if (esperarColaMensajes(cola, true, ms) < 0)
+        return -1;
+
+    int int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+    meterMensaje(cola->mensajes, msg, lon, prioridad);
+    memAccess = 0;
+
+    /* hay un mensaje para un receptor y, si sobra hueco, para otro emisor */
+    despertarDeCola(&cola->esperando_lect);
+    if (cola->mensajes->num_mensajes < cola->mensajes->max_mensajes)
+        despertarDeCola(&cola->esperando);
+    return 0;
+}
+
+/*
+ * Tratamiento de llamada al sistema recibir. Saca el mensaje mas
+ * prioritario en buf, esperando como mucho ms milisegundos (sin limite
+ * si es negativo) a que llegue alguno. Devuelve su longitud y deja su
+ * prioridad en *prioridad si no es NULL.
+ */
+int sis_recibir() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    char *buf = (char *) leer_registro(2);
+    int tam = (int) leer_registro(3);
+    int *prioridad = (int *) leer_registro(4);
+    int ms = (int) leer_registro(5);
+    mutex *cola = objetoDescriptor(descriptor, CLASE_COLA);
+    int lon, prio;
+
+    if (cola == NULL || buf == NULL || tam < 0)
+        return -1;
+    if (esperarColaMensajes(cola, false, ms) < 0)
+        return -1;
+
+    int int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+    lon = sacarMensaje(cola->mensajes, buf, tam, &prio);
+    if (lon >= 0 && prioridad != NULL)
+        *prioridad = prio;
+    memAccess = 0;
+
+    if (lon >= 0)
+        despertarDeCola(&cola->esperando);
+    if (cola->mensajes->num_mensajes > 0)
+        despertarDeCola(&cola->esperando_lect);
+    return lon;
+}
+
+/*
+ * Tratamiento de llamada al sistema recibir_lote. Espera como recibir a
+ * que haya algun mensaje y saca hasta n en el vector de mensajes, parando
+ * en el primero que no quepa en su buffer. Devuelve los recibidos.
+ */
+int sis_recibir_lote() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    struct mensaje *mensajes = (struct mensaje *) leer_registro(2);
+    int n = (int) leer_registro(3);
+    int ms = (int) leer_registro(4);
+    mutex *cola = objetoDescriptor(descriptor, CLASE_COLA);
+    int recibidos = 0, lon, i;
+
+    if (cola == NULL || mensajes == NULL || n <= 0)
+        return -1;
+    if (esperarColaMensajes(cola, false, ms) < 0)
+        return -1;
+
+    int int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+    while (recibidos < n && cola->mensajes->num_mensajes > 0) {
+        struct mensaje *m = &mensajes[recibidos];
+
+        lon = sacarMensaje(cola->mensajes, m->buf, m->tam, &m->prioridad);
+        if (lon < 0)
+            break;
+        m->lon = lon;
+        recibidos++;
+    }
+    memAccess = 0;
+
+    /* un emisor por cada hueco liberado */
+    for (i = 0; i < recibidos; i++)
+        despertarDeCola(&cola->esperando);
+    if (cola->mensajes->num_mensajes > 0)
+        despertarDeCola(&cola->esperando_lect);
+    return recibidos > 0 ? recibidos : -1;
+}
+
+int sis_cerrar_cola() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+
+    return cerrarDescriptor(descriptor, CLASE_COLA);
+}
+
+/*
+ *
+ * Segmentos de memoria compartida
+ *	soltarSegmentos
+ *
+ * Un segmento es un bloque de memoria del kernel con nombre. Proyectarlo
+ * lo anota en el mapa de segmentos de la imagen, que comparten todos sus
+ * hilos, y cuenta como una referencia mas, de modo que el segmento solo
+ * se destruye cuando se cierra el ultimo descriptor y se deshace la
+ * ultima proyeccion.
+ */
+
+/*
+ * Deshace todas las proyecciones de una imagen que ya no usa nadie
+ */
+static void soltarSegmentos(recursos_imagen *rec) {
+    int i;
+
+    for (i = 0; i < MAX_SEG_PROC; i++)
+        if (rec->segmentos[i] >= 0) {
+            cerrarObjeto(getMutex(rec->segmentos[i]), 0);
+            rec->segmentos[i] = -1;
+        }
+}
+
+/*
+ * Tratamiento de llamada al sistema crear_segmento. Crea un segmento con
+ * nombre de tam bytes iniciado a cero y devuelve su descriptor.
+ */
+int sis_crear_segmento() {
+    char *nombre = (char *) leer_registro(1);
+    int tam = (int) leer_registro(2);
+    char *memoria;
+    int descriptor;
+
+    if (tam <= 0 || tam > MAX_TAM_SEG)
+        return -1;
+    if ((memoria = calloc(1, tam)) == NULL)
+        return -1;
+    descriptor = crearObjeto(nombre, CLASE_SEGMENTO, 0);
+    if (descriptor < 0) {
+        free(memoria);
+        return -1;
+    }
+    mutex *seg = getMutex(p_proc_actual->mutexList[descriptor]);
+    seg->memoria = memoria;
+    seg->valor = tam;
+    return descriptor;
+}
+
+int sis_abrir_segmento() {
+    char *nombre = (char *) leer_registro(1);
+
+    return abrirObjeto(nombre, CLASE_SEGMENTO);
+}
+
+/*
+ * Tratamiento de llamada al sistema proyectar. Proyecta el segmento en
+ * el mapa de la imagen, deja su direccion en *dir y devuelve su tamano.
+ */
+int sis_proyectar() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+    void **dir = (void **) leer_registro(2);
+    mutex *seg = objetoDescriptor(descriptor, CLASE_SEGMENTO);
+    int i;
+
+    if (seg == NULL || dir == NULL)
+        return -1;
+    for (i = 0; i < MAX_SEG_PROC && p_proc_actual->recursos->segmentos[i] >= 0; i++);
+    if (i == MAX_SEG_PROC)
+        return -1;
+    p_proc_actual->recursos->segmentos[i] = seg->index;
+    seg->num_procesos++;
+
+    int int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+    *dir = seg->memoria;
+    memAccess = 0;
+    return seg->valor;
+}
+
+/*
+ * Tratamiento de llamada al sistema desproyectar. Deshace la proyeccion
+ * del segmento que empieza en dir y lo destruye si era su ultima
+ * referencia.
+ */
+int sis_desproyectar() {
+    char *dir = (char *) leer_registro(1);
+    int i;
+
+    for (i = 0; i < MAX_SEG_PROC; i++)
+        if (p_proc_actual->recursos->segmentos[i] >= 0
+            && getMutex(p_proc_actual->recursos->segmentos[i])->memoria == dir) {
+            cerrarObjeto(getMutex(p_proc_actual->recursos->segmentos[i]), 0);
+            p_proc_actual->recursos->segmentos[i] = -1;
+            return 0;
+        }
+    return -1;
+}
+
+int sis_cerrar_segmento() {
+    unsigned int descriptor = (unsigned int) leer_registro(1);
+
+    return cerrarDescriptor(descriptor, CLASE_SEGMENTO);
+}
+
+
+int sis_leer_caracter() {
+    int car;
+
+    /* caso comun: hay caracteres y se leen sin prohibir interrupciones */
+    if (lista_lectores.primero == NULL && (car = sacarBufferTerminal()) >= 0)
+        return car;
+
+    /* se comprueba de nuevo sin interrupciones del terminal para no
+       perder el despertar de un caracter que llegue entretanto */
+    int int_level = fijar_nivel_int(NIVEL_2);
+
+    if (p_proc_actual->no_bloqueante) {
+        car = sacarBufferTerminal();
+        fijar_nivel_int(int_level);
+        return car;
+    }
+
+    /* se respeta el orden de los que ya esperan; al despertar puede que
+       otro lector se haya adelantado y haya que volver a esperar */
+    if (lista_lectores.primero != NULL)
+        esperarTerminal(1);
+    while (pendientesTerminal() == 0)
+        esperarTerminal(1);
+    car = sacarBufferTerminal();
+    despertarLectorTerminal();
+    fijar_nivel_int(int_level);
+
+    return car;
+}
+
+/*
+ * Tratamiento de llamada al sistema leer. Espera a que haya al menos min
+ * caracteres en el terminal y copia hasta n en buf con una sola llamada.
+ * Con min igual a 0 no se bloquea. En modo canonico espera a una linea
+ * completa, sea cual sea min, y no copia mas alla de su final. Devuelve
+ * el numero de caracteres leidos. Si el proceso ha pedido lecturas no
+ * bloqueantes no espera y devuelve -1 si no hay nada que leer.
+ */
+int sis_leer() {
+    char *buf = (char *) leer_registro(1);
+    int n = (int) leer_registro(2);
+    int min = (int) leer_registro(3);
+    int leidos = 0, car;
+
+    if (buf == NULL || n < 0 || min < 0)
+        return -1;
+    if (min > n)
+        min = n;
+    if (min > (int) buf_term.mascara + 1)
+        min = buf_term.mascara + 1;
+    if (modo_term == MODO_CANONICO && min > 1)
+        min = 1;
+
+    int int_level = fijar_nivel_int(NIVEL_2);
+    if (p_proc_actual->no_bloqueante) {
+        if (n > 0 && pendientesTerminal() == 0) {
+            fijar_nivel_int(int_level);
+            return -1;
+        }
+    } else {
+        if (min > 0 && lista_lectores.primero != NULL)
+            esperarTerminal(min);
+        while (pendientesTerminal() < (unsigned int) min)
+            esperarTerminal(min);
+    }
+    fijar_nivel_int(int_level);
+
+    int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+
+    while (leidos < n && (car = sacarBufferTerminal()) >= 0) {
+        buf[leidos++] = car;
+        if (car == '\n' && modo_term == MODO_CANONICO)
+            break;
+    }
+    memAccess = 0;
+
+    int_level = fijar_nivel_int(NIVEL_2);
+    despertarLectorTerminal();
+    fijar_nivel_int(int_level);
+    return leidos;
+}
+
+/*
+ * Tratamiento de llamada al sistema modo_terminal. Devuelve el modo
+ * anterior. Al volver al modo crudo la linea a medio editar se entrega.
+ */
+int sis_modo_terminal() {
+    int modo = (int) leer_registro(1);
+    int anterior = modo_term;
+
+    if (modo != MODO_CRUDO && modo != MODO_CANONICO)
+        return -1;
+
+    int int_level = fijar_nivel_int(NIVEL_2);
+    modo_term = modo;
+    if (modo == MODO_CRUDO) {
+        publicarBufferTerminal();
+        despertarLectorTerminal();
+        notificarEventos();
+    }
+    fijar_nivel_int(int_level);
+    return anterior;
+}
+
+/*
+ * Tratamiento de llamada al sistema no_bloqueante. Con activar distinto
+ * de 0 las lecturas del terminal del proceso devuelven -1 en vez de
+ * bloquearse. Devuelve el valor anterior.
+ */
+int sis_no_bloqueante() {
+    int activar = (int) leer_registro(1);
+    int anterior = p_proc_actual->no_bloqueante;
+
+    p_proc_actual->no_bloqueante = (activar != 0);
+    return anterior;
+}
+
+/*
+ * Tratamiento de llamada al sistema buffer_salida. La biblioteca registra
+ * su buffer de salida y la variable con los bytes pendientes, que quedan
+ * asociados a todos los hilos del proceso.
+ */
+int sis_buffer_salida() {
+    char *buf = (char *) leer_registro(1);
+    int *lon = (int *) leer_registro(2);
+    int i;
+
+    if (buf == NULL || lon == NULL)
+        return -1;
+    for (i = 0; i < MAX_PROC; i++)
+        if (tabla_procs[i].estado != NO_USADA && tabla_procs[i].estado != TERMINADO
+            && tabla_procs[i].grupo == p_proc_actual->grupo) {
+            tabla_procs[i].salida_buf = buf;
+            tabla_procs[i].salida_lon = lon;
+        }
+    return 0;
+}
+
+/*
+ * Escribe lo que quede en el buffer de salida de la biblioteca de un
+ * proceso cuya imagen va a desaparecer
+ */
+void vaciarSalida(BCP *proc) {
+    if (proc->salida_buf == NULL)
+        return;
+
+    int int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+
+    if (*proc->salida_lon > 0 && *proc->salida_lon <= TAM_BUF_SALIDA) {
+        escribirConsola(proc->salida_buf, *proc->salida_lon);
+        *proc->salida_lon = 0;
+    }
+    memAccess = 0;
+}
+
+/*
+ * Despierta a todos los procesos de esperar_eventos para que comprueben
+ * sus fuentes
+ */
+void notificarEventos() {
+    if (lista_eventos.primero != NULL)
+        despertarTodos(&lista_eventos);
+}
+
+/*
+ * Marca en cada evento si su fuente esta preparada y devuelve cuantas lo
+ * estan, o -1 si alguna no es valida. Accede a memoria de usuario.
+ */
+int comprobarEventos(struct evento *eventos, int n) {
+    int i, listos = 0;
+
+    for (i = 0; i < n; i++) {
+        struct evento *ev = &eventos[i];
+        mutex *pMutex;
+
+        switch (ev->tipo) {
+            case EV_TERMINAL:
+                ev->listo = pendientesTerminal() > 0;
+                break;
+            case EV_MUTEX:
+                pMutex = objetoDescriptor(ev->id, CLASE_MUTEX);
+                if (pMutex == NULL)
+                    return -1;
+                ev->listo = pMutex->proceso_bloqueado == -1;
+                break;
+            default:
+                return -1;
+        }
+        listos += ev->listo;
+    }
+    return listos;
+}
+
+/*
+ * Tratamiento de llamada al sistema esperar_eventos. Bloquea al proceso
+ * hasta que este preparada alguna de las n fuentes de eventos o pasen ms
+ * milisegundos (sin limite si ms es negativo, sin esperar si es 0).
+ * Devuelve el numero de fuentes preparadas, 0 si vence el plazo.
+ */
+int sis_esperar_eventos() {
+    struct evento *eventos = (struct evento *) leer_registro(1);
+    int n = (int) leer_registro(2);
+    int ms = (int) leer_registro(3);
+    int plazo = 0, listos;
+
+    if (eventos == NULL || n <= 0)
+        return -1;
+    if (ms > 0)
+        plazo = plazoMs(ms);
+
+    /* sin interrupciones del terminal entre comprobar y bloquearse */
+    int int_level = fijar_nivel_int(NIVEL_2);
+    for (;;) {
+        int int_level_2 = fijar_nivel_int(NIVEL_3);
+        memAccess = 1;
+        fijar_nivel_int(int_level_2);
+        listos = comprobarEventos(eventos, n);
+        memAccess = 0;
+
+        if (listos != 0 || ms == 0 || (plazo != 0 && int_clock_counter >= plazo))
+            break;
+
+        esperarEnCola(&lista_eventos, plazo);
+    }
+    fijar_nivel_int(int_level);
+    return listos;
+}
+
+/*
+ *
+ * Ficheros del anfitrion y cache de paginas
+ *	iniciarCachePaginas buscarPagina usarPagina escribirPagina
+ *	expulsarPagina expulsarPaginas reservarPagina obtenerPagina
+ *	volcarCache soltarInodo leerFichero escribirFichero
+ *
+ * Los ficheros estan en el directorio DIR_FICHEROS del anfitrion. Se leen
+ * y escriben a traves de las paginas de la cache, que solo van al
+ * anfitrion al fallar, al expulsar una pagina sucia y en los volcados.
+ * Al cerrar un fichero sus paginas limpias se quedan en la cache, y con
+ * ellas su inodo, por si se vuelve a abrir; el inodo se libera cuando la
+ * LRU expulsa su ultima pagina o cuando hace falta para otro fichero.
+ * int_reloj pide los volcados periodicos pero se hacen al entrar en una
+ * llamada o en espera_int, igual que la recoleccion de recursos.
+ */
+
+static unsigned int hashPagina(inodo *ino, unsigned int num) {
+    return ((ino - tabla_inodos) * 31 + num) % NUM_PAGINAS;
+}
+
+/*
+ * Deja todas las paginas libres en la lista LRU y crea el directorio de
+ * los ficheros si no existe
+ */
+static void iniciarCachePaginas() {
+    int i;
+
+    for (i = 0; i < NUM_PAGINAS; i++) {
+        cache_pag.paginas[i].ino = NULL;
+        cache_pag.paginas[i].anterior = i > 0 ? &cache_pag.paginas[i - 1] : NULL;
+        cache_pag.paginas[i].siguiente =
+            i + 1 < NUM_PAGINAS ? &cache_pag.paginas[i + 1] : NULL;
+        cache_pag.hash[i] = NULL;
+    }
+    cache_pag.mas_usada = &cache_pag.paginas[0];
+    cache_pag.menos_usada = &cache_pag.paginas[NUM_PAGINAS - 1];
+    cache_pag.volcado_pendiente = 0;
+    memset(&cache_pag.estad, 0, sizeof(cache_pag.estad));
+    for (i = 0; i < MAX_INODOS; i++)
+        tabla_inodos[i].refs = tabla_inodos[i].paginas = 0;
+    mkdir(DIR_FICHEROS, 0755); /* falla si ya existe */
+}
+
+static pagina *buscarPagina(inodo *ino, unsigned int num) {
+    pagina *p = cache_pag.hash[hashPagina(ino, num)];
+
+    while (p != NULL && (p->ino != ino || p->num != num))
+        p = p->sig_hash;
+    return p;
+}
+
+/*
+ * Pone la pagina la primera de la lista LRU
+ */
+static void usarPagina(pagina *p) {
+    if (p == cache_pag.mas_usada)
+        return;
+    p->anterior->siguiente = p->siguiente;
+    if (p->siguiente != NULL)
+        p->siguiente->anterior = p->anterior;
+    else
+        cache_pag.menos_usada = p->anterior;
+    p->anterior = NULL;
+    p->siguiente = cache_pag.mas_usada;
+    cache_pag.mas_usada->anterior = p;
+    cache_pag.mas_usada = p;
+}
+
+/*
+ * Escribe en el anfitrion la parte de la pagina que esta dentro del
+ * fichero. Si no se escribe entera la pagina sigue sucia.
+ */
+static int escribirPagina(pagina *p) {
+    off_t inicio = (off_t) p->num * TAM_PAGINA;
+    size_t longi = p->ino->tam > inicio ? p->ino->tam - inicio : 0;
+
+    if (longi > TAM_PAGINA)
+        longi = TAM_PAGINA;
+    cache_pag.estad.escrituras++;
+    if (pwrite(p->ino->fd, p->datos, longi, inicio) != (ssize_t) longi)
+        return -1;
+    p->sucia = 0;
+    return 0;
+}
+
+/*
+ * Saca la pagina de la cache, escribiendola antes si esta sucia. Queda
+ * libre en su sitio de la lista LRU. Si era la ultima de un fichero
+ * cerrado, lo cierra en el anfitrion y libera su inodo. Devuelve -1, y
+ * la pagina se queda en la cache, si esta sucia y no se puede escribir.
+ */
+static int expulsarPagina(pagina *p) {
+    inodo *ino = p->ino;
+    pagina **pos;
+
+    if (ino == NULL)
+        return 0;
+    if (p->sucia && escribirPagina(p) < 0) {
+        printk("-> ERROR ESCRIBIENDO %s\n", ino->nombre);
+        return -1;
+    }
+    pos = &cache_pag.hash[hashPagina(ino, p->num)];
+    while (*pos != p)
+        pos = &(*pos)->sig_hash;
+    *pos = p->sig_hash;
+    p->ino = NULL;
+    if (--ino->paginas == 0 && ino->refs == 0)
+        close(ino->fd);
+    return 0;
+}
+
+/*
+ * Saca de la cache todas las paginas de ino. Con descartar a true no se
+ * escriben las sucias. Devuelve -1 si queda alguna que no se pudo
+ * escribir.
+ */
+static int expulsarPaginas(inodo *ino, bool descartar) {
+    int i, error = 0;
+
+    for (i = 0; i < NUM_PAGINAS && ino->paginas > 0; i++)
+        if (cache_pag.paginas[i].ino == ino) {
+            if (descartar)
+                cache_pag.paginas[i].sucia = 0;
+            if (expulsarPagina(&cache_pag.paginas[i]) < 0)
+                error = -1;
+        }
+    return error;
+}
+
+/*
+ * Asigna la pagina menos usada que se pueda expulsar a la pagina num de
+ * ino, sin leerla, y la pone la primera de la lista LRU. Las sucias que
+ * no se pueden escribir se saltan para no perder sus datos; devuelve
+ * NULL si no queda ninguna.
+ */
+static pagina *reservarPagina(inodo *ino, unsigned int num) {
+    pagina *p = cache_pag.menos_usada;
+    unsigned int h = hashPagina(ino, num);
+
+    while (p != NULL && expulsarPagina(p) < 0)
+        p = p->anterior;
+    if (p == NULL)
+        return NULL;
+    p->ino = ino;
+    p->num = num;
+    p->sucia = 0;
+    ino->paginas++;
+    p->sig_hash = cache_pag.hash[h];
+    cache_pag.hash[h] = p;
+    usarPagina(p);
+    return p;
+}
+
+/*
+ * Devuelve la pagina num de ino, leyendola del anfitrion si no esta en
+ * la cache. Con leer a false el llamante la sobrescribe entera y no se
+ * lee. Si falla una lectura secuencial se leen en la misma operacion las
+ * siguientes paginas que falten, hasta PAGINAS_ANTICIPADAS en total y
+ * nunca tantas como para que al reservarlas se expulse la primera; no
+ * se anticipa a costa de una pagina sucia. Devuelve NULL si no hay
+ * ninguna pagina que se pueda expulsar.
+ */
+static pagina *obtenerPagina(inodo *ino, unsigned int num, bool leer, bool secuencial) {
+    struct iovec iov[PAGINAS_ANTICIPADAS];
+    unsigned int num_paginas = (ino->tam + TAM_PAGINA - 1) / TAM_PAGINA;
+    pagina *p = buscarPagina(ino, num);
+    ssize_t leidos;
+    int n = 1, i;
+
+    if (p != NULL) {
+        cache_pag.estad.aciertos++;
+        usarPagina(p);
+        return p;
+    }
+    cache_pag.estad.fallos++;
+    if ((p = reservarPagina(ino, num)) == NULL)
+        return NULL;
+    if (num >= num_paginas) {
+        memset(p->datos, 0, TAM_PAGINA); /* todavia no esta en el fichero */
+        return p;
+    }
+    if (!leer)
+        return p;
+
+    iov[0].iov_base = p->datos;
+    iov[0].iov_len = TAM_PAGINA;
+    while (secuencial && n < PAGINAS_ANTICIPADAS && n < NUM_PAGINAS - 1
+           && num + n < num_paginas && !cache_pag.menos_usada->sucia
+           && buscarPagina(ino, num + n) == NULL) {
+        iov[n].iov_base = reservarPagina(ino, num + n)->datos;
+        iov[n].iov_len = TAM_PAGINA;
+        n++;
+    }
+    cache_pag.estad.anticipadas += n - 1;
+    cache_pag.estad.lecturas++;
+
+    leidos = -1;
+    if (lseek(ino->fd, (off_t) num * TAM_PAGINA, SEEK_SET) >= 0)
+        leidos = readv(ino->fd, iov, n);
+    if (leidos < 0)
+        leidos = 0;
+    /* lo que no esta en el anfitrion aun no se ha volcado: son ceros */
+    for (i = 0; i < n; i++, leidos -= TAM_PAGINA)
+        if (leidos < TAM_PAGINA)
+            memset((char *) iov[i].iov_base + (leidos > 0 ? leidos : 0), 0,
+                   TAM_PAGINA - (leidos > 0 ? leidos : 0));
+    return p;
+}
+
+/*
+ * Escribe las paginas sucias de ino, o de todos los ficheros si es NULL.
+ * Devuelve -1 si falla alguna escritura.
+ */
+static int volcarCache(inodo *ino) {
+    int i, error = 0;
+
+    if (ino == NULL)
+        cache_pag.volcado_pendiente = 0;
+    for (i = 0; i < NUM_PAGINAS; i++) {
+        pagina *p = &cache_pag.paginas[i];
+
+        if (p->ino != NULL && p->sucia && (ino == NULL || p->ino == ino)
+            && escribirPagina(p) < 0)
+            error = -1;
+    }
+    return error;
+}
+
+/*
+ * Quita una referencia al fichero del anfitrion. Con la ultima escribe
+ * sus paginas sucias; si no le queda ninguna en la cache lo cierra.
+ */
+static int soltarInodo(inodo *ino) {
+    int error;
+
+    if (--ino->refs > 0)
+        return 0;
+    error = volcarCache(ino);
+    if (ino->paginas == 0 && close(ino->fd) < 0)
+        error = -1;
+    return error;
+}
+
+/*
+ * Lee hasta n bytes desde la posicion del fichero, sin pasar del final.
+ * Si la cache esta llena de paginas que no se pueden escribir devuelve lo
+ * leido hasta entonces, o -1.
+ */
+static int leerFichero(fichero *f, char *buf, int n) {
+    inodo *ino = f->ino;
+    int hechos = 0;
+
+    if (f->posicion >= ino->tam)
+        return 0;
+    if (n > ino->tam - f->posicion)
+        n = ino->tam - f->posicion;
+    while (hechos < n) {
+        unsigned int num = f->posicion / TAM_PAGINA;
+        unsigned int desp = f->posicion % TAM_PAGINA;
+        int trozo = TAM_PAGINA - desp;
+        pagina *p;
+
+        if (trozo > n - hechos)
+            trozo = n - hechos;
+        p = obtenerPagina(ino, num, true, (int) num == f->ultima_pagina + 1);
+        if (p == NULL)
+            return hechos > 0 ? hechos : -1;
+
+        int int_level = fijar_nivel_int(NIVEL_3);
+        memAccess = 1;
+        fijar_nivel_int(int_level);
+        memcpy(buf + hechos, p->datos + desp, trozo);
+        memAccess = 0;
+
+        f->ultima_pagina = num;
+        f->posicion += trozo;
+        hechos += trozo;
+    }
+    return hechos;
+}
+
+/*
+ * Escribe n bytes en la posicion del fichero, alargandolo si hace falta.
+ * Las paginas quedan sucias en la cache hasta el siguiente volcado. Si no
+ * queda ninguna pagina que expulsar devuelve lo escrito, o -1.
+ */
+static int escribirFichero(fichero *f, char *buf, int n) {
+    inodo *ino = f->ino;
+    int hechos = 0;
+
+    while (hechos < n) {
+        unsigned int num = f->posicion / TAM_PAGINA;
+        unsigned int desp = f->posicion % TAM_PAGINA;
+        int trozo = TAM_PAGINA - desp;
+        pagina *p;
+
+        if (trozo > n - hechos)
+            trozo = n - hechos;
+        p = obtenerPagina(ino, num, trozo < TAM_PAGINA, false);
+        if (p == NULL)
+            return hechos > 0 ? hechos : -1;
+
+        int int_level = fijar_nivel_int(NIVEL_3);
+        memAccess = 1;
+        fijar_nivel_int(int_level);
+        memcpy(p->datos + desp, buf + hechos, trozo);
+        memAccess = 0;
+
+        p->sucia = 1;
+        f->posicion += trozo;
+        if (f->posicion > ino->tam)
+            ino->tam = f->posicion;
+        hechos += trozo;
+    }
+    return hechos;
+}
+
+/*
+ * Tratamiento de llamada al sistema abrir_fichero. Abre el fichero nombre
+ * del directorio DIR_FICHEROS con el modo FICH_LECTURA y/o
+ * FICH_ESCRITURA, mas FICH_CREAR y FICH_TRUNCAR, en el descriptor libre
+ * mas bajo. La posicion empieza al principio. En el anfitrion se abre
+ * solo para leer mientras nadie lo pida para escribir; para escribir se
+ * abre tambien para leer, porque la cache lee las paginas que se
+ * escriben a medias.
+ */
+int sis_abrir_fichero() {
+    char *nombre = (char *) leer_registro(1);
+    int flags = (int) leer_registro(2);
+    int modo = flags & (FICH_LECTURA | FICH_ESCRITURA);
+    char ruta[sizeof(DIR_FICHEROS) + MAX_NOM_FICH + 1];
+    char nom[MAX_NOM_FICH + 1];
+    inodo *ino = NULL, *libre = NULL, *cerrado = NULL;
+    fichero *f;
+    int fd, i;
+    size_t longi;
+
+    if (nombre == NULL || modo == 0
+        || ((flags & FICH_TRUNCAR) && !(modo & FICH_ESCRITURA)))
+        return -1;
+    int int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+    for (longi = 0; longi <= MAX_NOM_FICH && nombre[longi] != '\0'; longi++)
+        if (longi < MAX_NOM_FICH)
+            nom[longi] = nombre[longi];
+    memAccess = 0;
+    /* solo nombres del propio directorio */
+    if (longi == 0 || longi > MAX_NOM_FICH)
+        return -1;
+    nom[longi] = '\0';
+    if (nom[0] == '.' || strchr(nom, '/') != NULL)
+        return -1;
+
+    for (fd = 0; fd < MAX_FD_PROC && p_proc_actual->recursos->fds[fd] != NULL; fd++);
+    if (fd == MAX_FD_PROC)
+        return -1;
+
+    for (i = 0; i < MAX_INODOS && ino == NULL; i++)
+        if (tabla_inodos[i].refs == 0 && tabla_inodos[i].paginas == 0)
+            libre = libre != NULL ? libre : &tabla_inodos[i];
+        else if (strcmp(tabla_inodos[i].nombre, nom) == 0)
+            ino = &tabla_inodos[i];
+        else if (tabla_inodos[i].refs == 0 && cerrado == NULL)
+            cerrado = &tabla_inodos[i];
+    if (ino == NULL) {
+        off_t tam;
+
+        /* si no hay inodos libres se recupera uno cerrado que solo
+           conservaba paginas en la cache */
+        if (libre == NULL && cerrado != NULL
+            && expulsarPaginas(cerrado, false) == 0)
+            libre = cerrado;
+        if (libre == NULL)
+            return -1;
+        sprintf(ruta, "%s/%s", DIR_FICHEROS, nom);
+        libre->fd = open(ruta, ((modo & FICH_ESCRITURA) ? O_RDWR : O_RDONLY)
+                         | ((flags & FICH_CREAR) ? O_CREAT : 0), 0644);
+        if (libre->fd < 0)
+            return -1;
+        if ((tam = lseek(libre->fd, 0, SEEK_END)) < 0) {
+            close(libre->fd);
+            return -1;
+        }
+        ino = libre;
+        strcpy(ino->nombre, nom);
+        ino->escritura = (modo & FICH_ESCRITURA) != 0;
+        ino->paginas = 0;
+        ino->tam = tam;
+    } else if ((modo & FICH_ESCRITURA) && !ino->escritura) {
+        int fd_anf;
+
+        /* hasta ahora solo se leia: se reabre tambien para escribir */
+        sprintf(ruta, "%s/%s", DIR_FICHEROS, nom);
+        if ((fd_anf = open(ruta, O_RDWR)) < 0)
+            return -1;
+        close(ino->fd);
+        ino->fd = fd_anf;
+        ino->escritura = 1;
+    }
+    if ((f = reservar_objeto(&cache_ficheros)) == NULL) {
+        if (ino->refs == 0 && ino->paginas == 0)
+            close(ino->fd);
+        return -1;
+    }
+    ino->refs++;
+
+    if (flags & FICH_TRUNCAR) {
+        expulsarPaginas(ino, true);
+        if (ftruncate(ino->fd, 0) == 0)
+            ino->tam = 0;
+    }
+
+    f->modo = modo;
+    f->refs = 1;
+    f->tub = NULL;
+    f->ino = ino;
+    f->posicion = 0;
+    f->ultima_pagina = -1;
+    p_proc_actual->recursos->fds[fd] = f;
+    return fd;
+}
+
+/*
+ * Tratamiento de llamada al sistema posicionar. Mueve la posicion de un
+ * fichero del anfitrion desp bytes desde el principio, la posicion
+ * actual o el final y devuelve la nueva posicion. Se puede pasar del
+ * final; el hueco se lee como ceros si luego se escribe detras.
+ */
+int sis_posicionar() {
+    unsigned int fd = (unsigned int) leer_registro(1);
+    int desp = (int) leer_registro(2);
+    int origen = (int) leer_registro(3);
+    long posicion;
+    fichero *f;
+
+    if (fd >= MAX_FD_PROC || (f = p_proc_actual->recursos->fds[fd]) == NULL || f->ino == NULL)
+        return -1;
+    if (origen == POS_INICIO)
+        posicion = desp;
+    else if (origen == POS_ACTUAL)
+        posicion = (long) f->posicion + desp;
+    else if (origen == POS_FINAL)
+        posicion = (long) f->ino->tam + desp;
+    else
+        return -1;
+    if (posicion < 0 || posicion > INT_MAX)
+        return -1;
+    f->posicion = posicion;
+    return posicion;
+}
+
+/*
+ * Tratamiento de llamada al sistema estad_cache. Copia los contadores de
+ * la cache de paginas.
+ */
+int sis_estad_cache() {
+    struct estad_cache *estad = (struct estad_cache *) leer_registro(1);
+
+    if (estad == NULL)
+        return -1;
+    int int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+    *estad = cache_pag.estad;
+    memAccess = 0;
+    return 0;
+}
+
+/*
+ *
+ * Tuberias y descriptores de fichero
+ *	crearRecursos soltarRecursos soltarFichero ficheroDescriptor
+ *	leerTuberia escribirTuberia
+ *
+ * Cada imagen tiene una tabla de MAX_FD_PROC descriptores que apuntan a
+ * ficheros abiertos y que usan todos sus hilos. Un proceso nuevo, o uno
+ * que ejecuta otro programa mientras sus hilos siguen con la imagen
+ * anterior, recibe una copia de la tabla de su creador, compartiendo los
+ * ficheros.
+ */
+
+/*
+ * Reserva los recursos de una imagen nueva con una copia de los
+ * descriptores de padre y sin proyecciones. El proceso inicial no tiene
+ * creador y empieza sin ningun descriptor. Devuelve NULL si no hay
+ * memoria.
+ */
+recursos_imagen *crearRecursos(recursos_imagen *padre) {
+    recursos_imagen *rec;
+    int i;
+
+    if ((rec = reservar_objeto(&cache_imagenes)) == NULL)
+        return NULL;
+    for (i = 0; i < MAX_FD_PROC; i++) {
+        rec->fds[i] = padre != NULL ? padre->fds[i] : NULL;
+        if (rec->fds[i] != NULL)
+            rec->fds[i]->refs++;
+    }
+    for (i = 0; i < MAX_SEG_PROC; i++)
+        rec->segmentos[i] = -1;
+    return rec;
+}
+
+/*
+ * Deshace las proyecciones y cierra los descriptores de una imagen que
+ * ya no usa nadie, y devuelve sus recursos a la cache
+ */
+void soltarRecursos(recursos_imagen *rec) {
+    int i;
+
+    soltarSegmentos(rec);
+    for (i = 0; i < MAX_FD_PROC; i++)
+        if (rec->fds[i] != NULL)
+            soltarFichero(rec->fds[i]);
+    liberar_objeto(&cache_imagenes, rec);
+}
+
+/*
+ * Quita una referencia a un fichero. Al cerrarse el ultimo extremo de
+ * un tipo despierta a todos los que esperan en el otro: los lectores
+ * veran el fin de los datos y los escritores un error. Al cerrarse un
+ * fichero del anfitrion se escriben sus paginas sucias; devuelve -1 si
+ * falla.
+ */
+int soltarFichero(fichero *f) {
+    tuberia *tub = f->tub;
+    inodo *ino = f->ino;
+
+    if (--f->refs > 0)
+        return 0;
+    if (ino != NULL) {
+        liberar_objeto(&cache_ficheros, f);
+        return soltarInodo(ino);
+    }
+    if (f->modo == FICH_LECTURA) {
+        if (--tub->lectores == 0)
+            despertarTodos(&tub->esperan_escr);
+    } else {
+        if (--tub->escritores == 0)
+            despertarTodos(&tub->esperan_lect);
+    }
+    liberar_objeto(&cache_ficheros, f);
+    if (tub->lectores == 0 && tub->escritores == 0)
+        liberar_objeto(&cache_tuberias, tub);
+    return 0;
+}
+
+static fichero *ficheroDescriptor(unsigned int fd, int modo) {
+    if (fd >= MAX_FD_PROC || p_proc_actual->recursos->fds[fd] == NULL
+        || (p_proc_actual->recursos->fds[fd]->modo & modo) == 0)
+        return NULL;
+    return p_proc_actual->recursos->fds[fd];
+}
+
+/*
+ * Lee hasta n bytes de la tuberia. Solo se bloquea si esta vacia y
+ * queda algun escritor; devuelve 0 si esta vacia y no queda ninguno.
+ */
+static int leerTuberia(tuberia *tub, char *buf, int n) {
+    int leidos = 0;
+
+    while (tub->cabeza == tub->cola && tub->escritores > 0)
+        esperarEnCola(&tub->esperan_lect, 0);
+
+    int int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+    while (leidos < n && tub->cola != tub->cabeza)
+        buf[leidos++] = tub->datos[tub->cola++ & (TAM_TUBERIA - 1)];
+    memAccess = 0;
+
+    /* hay sitio para un escritor y, si sobran datos, para otro lector */
+    if (leidos > 0)
+        despertarDeCola(&tub->esperan_escr);
+    if (tub->cola != tub->cabeza)
+        despertarDeCola(&tub->esperan_lect);
+    return leidos;
+}
+
+/*
+ * Escribe los n bytes en la tuberia, bloqueandose cada vez que se llena.
+ * Si no quedan lectores devuelve -1, o lo escrito hasta entonces.
+ */
+static int escribirTuberia(tuberia *tub, char *buf, int n) {
+    int escritos = 0;
+
+    while (escritos < n) {
+        unsigned int libre = TAM_TUBERIA - (tub->cabeza - tub->cola);
+
+        if (tub->lectores == 0)
+            return escritos > 0 ? escritos : -1;
+        if (libre == 0) {
+            esperarEnCola(&tub->esperan_escr, 0);
+            continue;
+        }
+
+        int int_level = fijar_nivel_int(NIVEL_3);
+        memAccess = 1;
+        fijar_nivel_int(int_level);
+        while (escritos < n && libre-- > 0)
+            tub->datos[tub->cabeza++ & (TAM_TUBERIA - 1)] = buf[escritos++];
+        memAccess = 0;
+
+        despertarDeCola(&tub->esperan_lect);
+    }
+    if (tub->cabeza - tub->cola < TAM_TUBERIA)
+        despertarDeCola(&tub->esperan_escr);
+    return escritos;
+}
+
+/*
+ * Tratamiento de llamada al sistema crear_tuberia. Deja en fds[0] el
+ * descriptor del extremo de lectura y en fds[1] el de escritura.
+ */
+int sis_crear_tuberia() {
+    int *fds = (int *) leer_registro(1);
+    fichero *lect, *escr;
+    tuberia *tub;
+    int libres[2], n = 0, i;
+
+    /* los dos descriptores libres mas bajos */
+    for (i = 0; i < MAX_FD_PROC && n < 2; i++)
+        if (p_proc_actual->recursos->fds[i] == NULL)
+            libres[n++] = i;
+    if (fds == NULL || n < 2)
+        return -1;
+
+    tub = reservar_objeto(&cache_tuberias);
+    lect = reservar_objeto(&cache_ficheros);
+    escr = reservar_objeto(&cache_ficheros);
+    if (tub == NULL || lect == NULL || escr == NULL) {
+        if (tub != NULL)
+            liberar_objeto(&cache_tuberias, tub);
+        if (lect != NULL)
+            liberar_objeto(&cache_ficheros, lect);
+        if (escr != NULL)
+            liberar_objeto(&cache_ficheros, escr);
+        return -1;
+    }
+    tub->cabeza = tub->cola = 0;
+    tub->lectores = tub->escritores = 1;
+    tub->esperan_lect.primero = tub->esperan_lect.ultimo = NULL;
+    tub->esperan_escr.primero = tub->esperan_escr.ultimo = NULL;
+    lect->modo = FICH_LECTURA;
+    escr->modo = FICH_ESCRITURA;
+    lect->refs = escr->refs = 1;
+    lect->tub = escr->tub = tub;
+    lect->ino = escr->ino = NULL;
+    p_proc_actual->recursos->fds[libres[0]] = lect;
+    p_proc_actual->recursos->fds[libres[1]] = escr;
+
+    int int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+    fds[0] = libres[0];
+    fds[1] = libres[1];
+    memAccess = 0;
+    return 0;
+}
+
+int sis_leer_fd() {
+    unsigned int fd = (unsigned int) leer_registro(1);
+    char *buf = (char *) leer_registro(2);
+    int n = (int) leer_registro(3);
+    fichero *f = ficheroDescriptor(fd, FICH_LECTURA);
+
+    if (f == NULL || buf == NULL || n < 0)
+        return -1;
+    if (f->ino != NULL)
+        return leerFichero(f, buf, n);
+    return leerTuberia(f->tub, buf, n);
+}
+
+int sis_escribir_fd() {
+    unsigned int fd = (unsigned int) leer_registro(1);
+    char *buf = (char *) leer_registro(2);
+    int n = (int) leer_registro(3);
+    fichero *f = ficheroDescriptor(fd, FICH_ESCRITURA);
+
+    if (f == NULL || buf == NULL || n < 0)
+        return -1;
+    if (f->ino != NULL)
+        return escribirFichero(f, buf, n);
+    return escribirTuberia(f->tub, buf, n);
+}
+
+int sis_cerrar_fd() {
+    unsigned int fd = (unsigned int) leer_registro(1);
+    fichero *f;
+
+    if (fd >= MAX_FD_PROC || (f = p_proc_actual->recursos->fds[fd]) == NULL)
+        return -1;
+    p_proc_actual->recursos->fds[fd] = NULL;
+    return soltarFichero(f);
+}
+
+/*
+ * Tratamiento de llamada al sistema crear_hilo. Crea un hilo que comparte
+ * la imagen del proceso actual pero con pila y contexto propios. El hilo
+ * arranca en la rutina de la biblioteca que recibe en el registro 1, que
+ * obtiene la funcion y su argumento mediante la llamada datos_hilo.
+ * Comparte los ficheros y las proyecciones de la imagen, pero empieza sin
+ * descriptores de mutex y demas objetos con nombre: guardan estado de
+ * cada hilo (locks de lectura, participacion en una barrera), asi que
+ * el hilo abre por nombre los que necesite.
+ */
+int sis_crear_hilo() {
+    void *pc_inicial = (void *) leer_registro(1);
+    int proc;
+    BCP *p_proc;
+
+    printk("-> PROC %d: CREAR HILO\n", p_proc_actual->id);
+    proc = buscar_BCP_libre();
+    if (proc == -1)
+        return -1;    /* no hay entrada libre */
+
+    p_proc = &(tabla_procs[proc]);
+    if (iniciarDescriptores(p_proc) < 0)
+        return -1;
+    p_proc->info_mem = p_proc_actual->info_mem;
+    p_proc->recursos = p_proc_actual->recursos;
+    p_proc->pila = crear_pila(TAM_PILA);
+    if (p_proc->pila == NULL)
+        return -1;    /* no hay memoria para la pila */
+    fijar_contexto_ini(p_proc->info_mem, p_proc->pila, TAM_PILA,
+                       pc_inicial,
+                       &(p_proc->contexto_regs));
+    p_proc->funcion_hilo = (void *) leer_registro(2);
+    p_proc->arg_hilo = (void *) leer_registro(3);
+    iniciar_BCP(p_proc, proc, p_proc_actual->grupo);
+    p_proc->salida_buf = p_proc_actual->salida_buf;
+    p_proc->salida_lon = p_proc_actual->salida_lon;
+    return proc;
+}
+
+/*
+ * Tratamiento de llamada al sistema datos_hilo. Copia en el vector
+ * de la biblioteca la funcion inicial del hilo actual y su argumento.
+ */
+int sis_datos_hilo() {
+    void **datos = (void **) leer_registro(1);
+
+    if (datos == NULL)
+        return -1;
+    int int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+    datos[0] = p_proc_actual->funcion_hilo;
+    datos[1] = p_proc_actual->arg_hilo;
+    memAccess = 0;
+    return 0;
+}
+
+/*
+ * Tratamiento de llamada al sistema terminar_hilo. Guarda el valor de
+ * terminacion para esperar_hilo y llama a liberar_proceso
+ */
+int sis_terminar_hilo() {
+
+    printk("-> FIN HILO %d\n", p_proc_actual->id);
+
+    p_proc_actual->valor_hilo = (int) leer_registro(1);
+    liberar_proceso();
+
+    return 0; /* no deber�a llegar aqui */
+}
+
+/*
+ * Tratamiento de llamada al sistema esperar_hilo. Bloquea al proceso
+ * hasta que termine el hilo indicado, que debe pertenecer a su mismo
+ * grupo, y devuelve su valor de terminacion.
+ */
+int sis_esperar_hilo() {
+    int id = (int) leer_registro(1);
+    int grupo = p_proc_actual->grupo;
+    BCP *hilo;
+
+    if (id < 0 || id >= MAX_PROC || id == p_proc_actual->id)
+        return -1;
+    hilo = &(tabla_procs[id]);
+
+    while (hilo->estado != ZOMBI) {
+        if (hilo->estado == NO_USADA || hilo->grupo != grupo)
+            return -1;
+
+        p_proc_actual->estado = BLOQUEADO;
+        p_proc_actual->hilo_esperado = id;
+        anadirProcesoAListaBloqueados(p_proc_actual);
+
+        BCP *p_proc_blocked = p_proc_actual;
+        p_proc_actual = planificador();
+        cambio_contexto(&(p_proc_blocked->contexto_regs), &(p_proc_actual->contexto_regs));
+    }
+    if (hilo->grupo != grupo)
+        return -1;
+
+    hilo->estado = NO_USADA;
+    return hilo->valor_hilo;
+}
+
+/*
+ * Tratamiento de llamada al sistema ejecutar. Sustituye la imagen del
+ * proceso actual por la del programa prog conservando su BCP, su id y
+ * sus descriptores, pero no sus proyecciones, y lo arranca desde el
+ * principio con una pila nueva. Si el proceso compartia imagen con otros
+ * hilos, pasa a formar un grupo propio.
+ */
+int sis_ejecutar() {
+    char *prog = (char *) leer_registro(1);
+    void *imagen, *pc_inicial;
+    void *imagen_anterior = p_proc_actual->info_mem;
+    void *pila_anterior = p_proc_actual->pila;
+    int grupo_anterior = p_proc_actual->grupo;
+    recursos_imagen *recursos_anteriores = p_proc_actual->recursos;
+    recursos_imagen *recursos;
+
+    printk("-> PROC %d: EJECUTAR %s\n", p_proc_actual->id, prog);
+
+    /* crea la nueva imagen antes de soltar la anterior, con una copia de
+       los descriptores por si otros hilos siguen usando la anterior */
+    recursos = crearRecursos(recursos_anteriores);
+    if (recursos == NULL)
+        return -1;
+    imagen = crear_imagen(prog, &pc_inicial);
+    if (!imagen) {
+        soltarRecursos(recursos);
+        return -1; /* fallo al crear imagen: sigue con la actual */
+    }
+    num_imagenes++;
+
+    p_proc_actual->info_mem = imagen;
+    p_proc_actual->recursos = recursos;
+    p_proc_actual->grupo = cont_grupos++;
+    despertarEsperaHilo(p_proc_actual->id);
+    if (!imagenEnUso(grupo_anterior))
+        vaciarSalida(p_proc_actual);
+    p_proc_actual->salida_buf = NULL;
+    p_proc_actual->salida_lon = NULL;
+    if (!imagenEnUso(grupo_anterior)) {
+        liberarZombis(grupo_anterior);
+        soltarRecursos(recursos_anteriores);
+        diferir_liberacion(NULL, imagen_anterior);
+    }
+
+    p_proc_actual->pila = crear_pila(TAM_PILA);
+    fijar_contexto_ini(p_proc_actual->info_mem, p_proc_actual->pila, TAM_PILA,
+                       pc_inicial,
+                       &(p_proc_actual->contexto_regs));
+    diferir_liberacion(pila_anterior, NULL);
+    cambio_contexto(NULL, &(p_proc_actual->contexto_regs));
+
+    return 0; /* no deber�a llegar aqui */
+}
+
+/*
+ * Tratamiento de llamada al sistema futex_esperar. Bloquea al proceso
+ * mientras la palabra de usuario dir contenga valor. La comprobacion y
+ * el bloqueo no pueden intercalarse con otro proceso, por lo que un
+ * futex_despertar posterior al cambio del valor no se pierde.
+ * Devuelve 0 al ser despertado y -1 si el valor ya no coincidia.
+ */
+int sis_futex_esperar() {
+    int *dir = (int *) leer_registro(1);
+    int valor = (int) leer_registro(2);
+    int actual;
+
+    if (dir == NULL)
+        return -1;
+
+    int int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+    actual = *dir;
+    memAccess = 0;
+    if (actual != valor)
+        return -1;
+
+    p_proc_actual->estado = BLOQUEADO;
+    p_proc_actual->futex_dir = dir;
+
+    int_level = fijar_nivel_int(NIVEL_3);
+    eliminar_elem(&lista_listos, p_proc_actual);
+    insertar_ultimo(colaFutex(dir), p_proc_actual);
+    fijar_nivel_int(int_level);
+
+    BCP *p_proc_blocked = p_proc_actual;
+    p_proc_actual = planificador();
+    cambio_contexto(&(p_proc_blocked->contexto_regs), &(p_proc_actual->contexto_regs));
+    return 0;
+}
+
+/*
+ * Tratamiento de llamada al sistema futex_despertar. Desbloquea, en orden
+ * de llegada, hasta n procesos que esperan en la palabra dir y devuelve
+ * cuantos ha desbloqueado.
+ */
+int sis_futex_despertar() {
+    int *dir = (int *) leer_registro(1);
+    int n = (int) leer_registro(2);
+    lista_BCPs *cola = colaFutex(dir);
+    BCP *proc = cola->primero;
+    int despertados = 0;
+
+    while (proc != NULL && despertados < n) {
+        BCP *proc_siguiente = proc->siguiente;
+        if (proc->futex_dir == dir) {
+            proc->estado = LISTO;
+            proc->futex_dir = NULL;
+
+            int int_level = fijar_nivel_int(NIVEL_3);
+            eliminar_elem(cola, proc);
+            insertar_ultimo(&lista_listos, proc);
+            fijar_nivel_int(int_level);
+            despertados++;
+        }
+        proc = proc_siguiente;
+    }
+    return despertados;
+}
+
+/******************************************
+ * ****************************************
+ * ******** Funciones auxiliares **********
+ * ****************************************
+ * ****************************************
+ */
+
+void anadirProcesoAListaBloqueados(BCP *proc) {
+    int int_level = fijar_nivel_int(NIVEL_3);
+    eliminar_elem(&lista_listos, proc);
+    insertar_ultimo(&lista_blocked, proc);
+    fijar_nivel_int(int_level);
+}
+
+void eliminarProcesoListaBloqueados(BCP *proceso_bloqueado) {
+    int int_level = fijar_nivel_int(NIVEL_3);
+    eliminar_elem(&lista_blocked, proceso_bloqueado);
+    insertar_ultimo(&lista_listos, proceso_bloqueado);
+    fijar_nivel_int(int_level);
+}
+
+/*
+ * Devuelve el tick en que vencen ms milisegundos a partir de ahora, o 0
+ * (sin limite) si ese tick no cabe en un int
+ */
+int plazoMs(unsigned int ms) {
+    unsigned long long ticks = MS_A_TICKS(ms);
+
+    if (ticks > (unsigned long long) (INT_MAX - int_clock_counter))
+        return 0;
+    return int_clock_counter + (int) ticks;
+}
+
+/*
+ * Inserta al proceso en lista_temporizados en orden de plazo. Se llama
+ * con las interrupciones de reloj inhibidas.
+ */
+void armarTemporizador(BCP *proc, int plazo) {
+    BCP **pos = &lista_temporizados;
+
+    while (*pos != NULL && (*pos)->plazo <= plazo)
+        pos = &((*pos)->siguiente_temp);
+    proc->plazo = plazo;
+    proc->siguiente_temp = *pos;
+    *pos = proc;
+}
+
+/*
+ * Saca al proceso de lista_temporizados antes de que venza su plazo.
+ * Se llama con las interrupciones de reloj inhibidas.
+ */
+void quitarTemporizador(BCP *proc) {
+    BCP **pos = &lista_temporizados;
+
+    while (*pos != NULL && *pos != proc)
+        pos = &((*pos)->siguiente_temp);
+    if (*pos != NULL)
+        *pos = proc->siguiente_temp;
+    proc->plazo = 0;
+}
+
+/*
+ * Desbloquea a los procesos cuyo plazo ha vencido, que estan al principio
+ * de lista_temporizados. Si esperaban en un mutex los saca de su cola.
+ * Invocada desde int_reloj.
+ */
+void venceTemporizadores() {
+    while (lista_temporizados != NULL && lista_temporizados->plazo <= int_clock_counter) {
+        BCP *proc = lista_temporizados;
+
+        lista_temporizados = proc->siguiente_temp;
+        proc->plazo = 0;
+        if (proc->cola_espera != NULL) {
+            eliminar_elem(proc->cola_espera, proc);
+            proc->cola_espera = NULL;
+        }
+        proc->estado = LISTO;
+        insertar_ultimo(&lista_listos, proc);
+    }
+}
+
+/*
+ * Cola de futex_esperar en la que se bloquean los procesos que esperan
+ * en la palabra de usuario dir
+ */
+lista_BCPs *colaFutex(int *dir) {
+    return &colas_futex[((unsigned long) dir / sizeof(int)) & (TAM_HASH_FUTEX - 1)];
+}
+
+/*
+ * Indica si queda algun hilo vivo del grupo que use su imagen
+ */
+bool imagenEnUso(int grupo) {
+    int i;
+
+    for (i = 0; i < MAX_PROC; i++)
+        if (tabla_procs[i].estado != NO_USADA && tabla_procs[i].estado != ZOMBI
+            && tabla_procs[i].grupo == grupo)
+            return true;
+    return false;
+}
+
+/*
+ * Libera las entradas de los hilos del grupo que nadie llego a esperar
+ */
+void liberarZombis(int grupo) {
+    int i;
+
+    for (i = 0; i < MAX_PROC; i++)
+        if (tabla_procs[i].estado == ZOMBI && tabla_procs[i].grupo == grupo)
+            tabla_procs[i].estado = NO_USADA;
+}
+
+/*
+ * Desbloquea a los procesos que esperan en esperar_hilo al hilo id
+ */
+void despertarEsperaHilo(int id) {
+    BCP *proceso_bloqueado = lista_blocked.primero;
+
+    while (proceso_bloqueado != NULL) {
+        BCP *proceso_siguiente = proceso_bloqueado->siguiente;
+        if (proceso_bloqueado->hilo_esperado == id) {
+            proceso_bloqueado->estado = LISTO;
+            proceso_bloqueado->hilo_esperado = -1;
+            eliminarProcesoListaBloqueados(proceso_bloqueado);
+        }
+        proceso_bloqueado = proceso_siguiente;
+    }
+}
+
+/*
+ * Cierra para el proceso actual el mutex de su descriptor. Si lo tiene
+ * otro proceso y esperar es false, o se llega al tick plazo (0 sin
+ * limite), desiste. Devuelve 0 si lo obtiene, 1 si desiste y -1 si hay
+ * error.
+ */
+int lockMutex(unsigned int descriptor, int plazo, bool esperar) {
+    mutex *mutex1 = objetoDescriptor(descriptor, CLASE_MUTEX);
+    if (mutex1 == NULL)
+        return -1;
+
+    if (mutex1->proceso_bloqueado == p_proc_actual->id) {
+        if (!(mutex1->tipo & RECURSIVO))
+            return -1; /* segundo lock sobre un mutex no recursivo */
+        mutex1->num_bloqueos++;
+        return 0;
+    }
+    if (!esperar && mutex1->proceso_bloqueado != -1) {
+        mutex1->estad.desistidos++;
+        return 1;
+    }
+    return adquirirMutexHasta(mutex1, plazo);
+}
+
+/*
+ * Tratamiento de llamada al sistema estad_mutex. Copia en tabla las
+ * estadisticas de como mucho max mutex existentes y devuelve cuantas ha
+ * copiado.
+ */
+int sis_estad_mutex() {
+    struct estad_mutex *tabla = (struct estad_mutex *) leer_registro(1);
+    int max = (int) leer_registro(2);
+    int i, n = 0;
+
+    if (tabla == NULL)
+        return -1;
+
+    int int_level = fijar_nivel_int(NIVEL_3);
+    memAccess = 1;
+    fijar_nivel_int(int_level);
+
+    for (i = 0; i < tam_tabla_mutex && n < max; i++)
+        if (tabla_mutex[i].pMutex != NULL && tabla_mutex[i].pMutex->clase == CLASE_MUTEX)
+            leerEstadMutex(tabla_mutex[i].pMutex, &tabla[n++]);
+    memAccess = 0;
+    return n;
+}
+
+/*
+ * Crea un objeto de sincronizacion de la clase indicada y le asigna un
+ * descriptor del proceso actual. Falla si ya hay MAX_MUT objetos.
+ */
+int crearObjeto(char *nombre, int clase, int tipo) {
+
+    if (!verificaCondiciones(nombre))
+        return -1;
+    if (cont_mutex >= MAX_MUT)
+        return -1;
+
+    int descriptor = reservarDescriptor();
+    if (descriptor < 0)
+        return -1;
+    int mutex_id = crearMutex(nombre, clase, tipo);
+    if (mutex_id < 0) {
+        liberarDescriptor(descriptor);
+        return -1;
+    }
+    p_proc_actual->mutexList[descriptor] = mutex_id;
+    cont_mutex++;
+    return descriptor;
+}
+
+/*
+ * Asigna al proceso actual un descriptor del objeto de la clase indicada
+ * con ese nombre
+ */
+int abrirObjeto(char *nombre, int clase) {
+    mutex *mutex1 = buscarMutexPorNombre(nombre);
+    if (mutex1 == NULL || mutex1->clase != clase)
+        return -1;
+    int descriptor = reservarDescriptor();
+    if (descriptor < 0)
+        return -1;
+    p_proc_actual->mutexList[descriptor] = mutex1->index;
+    mutex1->num_procesos++;
+    return descriptor;
+}
+
+/*
+ * Devuelve el objeto asociado al descriptor del proceso actual, o NULL si
+ * el descriptor no es valido o el objeto no es de la clase indicada
+ */
+mutex *objetoDescriptor(unsigned int descriptor, int clase) {
+    mutex *mutex1;
+
+    if (descriptor >= (unsigned int) p_proc_actual->tam_desc)
+        return NULL;
+    mutex1 = getMutex(p_proc_actual->mutexList[descriptor]);
+    if (mutex1 == NULL || mutex1->clase != clase)
+        return NULL;
+    return mutex1;
+}
+
+/*
+ * Libera el descriptor del proceso actual y cierra el objeto asociado
+ */
+int cerrarDescriptor(unsigned int descriptor, int clase) {
+    mutex *mutex1 = objetoDescriptor(descriptor, clase);
+
+    if (mutex1 == NULL)
+        return -1;
+    cerrarObjeto(mutex1, p_proc_actual->lecturas[descriptor]);
+    liberarDescriptor(descriptor);
+    return 0;
+}
+
+/*
+ * Bloquea al proceso actual al final de una cola de espera. Si plazo no
+ * es 0, al llegar a ese tick int_reloj lo saca de la cola.
+ */
+void esperarEnCola(lista_BCPs *cola, int plazo) {
+    p_proc_actual->estado = BLOQUEADO;
+    p_proc_actual->cola_espera = cola;
+
+    int int_level = fijar_nivel_int(NIVEL_3);
+    eliminar_elem(&lista_listos, p_proc_actual);
+    insertar_ultimo(cola, p_proc_actual);
+    if (plazo != 0)
+        armarTemporizador(p_proc_actual, plazo);
+    fijar_nivel_int(int_level);
+
+    BCP *p_proc_blocked = p_proc_actual;
+    p_proc_actual = planificador();
+    cambio_contexto(&(p_proc_blocked->contexto_regs), &(p_proc_actual->contexto_regs));
+}
+
+void esperarMutex(mutex *pMutex) {
+    esperarEnCola(&(pMutex->esperando), 0);
+}
+
+/*
+ * Desbloquea al primer proceso de una cola de espera de un objeto.
+ * Devuelve el proceso desbloqueado o NULL si no habia ninguno.
+ */
+BCP *despertarDeCola(lista_BCPs *cola) {
+    /* int_reloj puede sacar de la cola a un proceso cuyo plazo vence */
+    int int_level = fijar_nivel_int(NIVEL_3);
+    BCP *proc = cola->primero;
+
+    if (proc != NULL) {
+        proc->estado = LISTO;
+        proc->cola_espera = NULL;
+        if (proc->plazo != 0)
+            quitarTemporizador(proc);
+        eliminar_primero(cola);
+        insertar_ultimo(&lista_listos, proc);
+    }
+    fijar_nivel_int(int_level);
+    return proc;
+}
+
+BCP *despertarPrimero(mutex *pMutex) {
+    return despertarDeCola(&(pMutex->esperando));
+}
+
+/*
+ * Desbloquea a todos los procesos de una cola de espera de un objeto.
+ * La cola entera se engancha a la de listos de una vez, por lo que las
+ * interrupciones solo se inhiben durante un tiempo constante.
+ * Devuelve cuantos procesos ha desbloqueado.
+ */
+int despertarTodos(lista_BCPs *cola) {
+    BCP *proc;
+    int despertados = 0;
+
+    /* int_reloj puede sacar de la cola a un proceso cuyo plazo vence */
+    int int_level = fijar_nivel_int(NIVEL_3);
+    for (proc = cola->primero; proc != NULL; proc = proc->siguiente) {
+        proc->estado = LISTO;
+        proc->cola_espera = NULL;
+        if (proc->plazo != 0)
+            quitarTemporizador(proc);
+        despertados++;
+    }
+    concatenar_lista(&lista_listos, cola);
+    fijar_nivel_int(int_level);
+    return despertados;
+}
+
+/*
+ * Cierra el mutex para el proceso actual, bloqueandolo mientras lo tenga
+ * otro, como mucho hasta el tick plazo (0 sin limite). Con TRASPASO puede
+ * recibir la propiedad al despertar. Devuelve 0 si lo obtiene y 1 si
+ * vence el plazo.
+ */
+int adquirirMutexHasta(mutex *pMutex, int plazo) {
+    int inicio = int_clock_counter;
+    bool con_espera = false;
+
+    while (pMutex->proceso_bloqueado != -1) {
+        if (plazo != 0 && int_clock_counter >= plazo) {
+            pMutex->estad.desistidos++;
+            return 1;
+        }
+        con_espera = true;
+        esperarEnCola(&(pMutex->esperando), plazo);
+        if (pMutex->proceso_bloqueado == p_proc_actual->id) {
+            anotarAdquisicion(pMutex, inicio, con_espera);
+            return 0;
+        }
+    }
+    pMutex->proceso_bloqueado = p_proc_actual->id;
+    pMutex->num_bloqueos = 1;
+    pMutex->cerrado_desde = int_clock_counter;
+    anotarAdquisicion(pMutex, inicio, con_espera);
+    return 0;
+}
+
+/*
+ * Anota en las estadisticas del mutex un lock obtenido tras pedirlo en
+ * el tick inicio
+ */
+void anotarAdquisicion(mutex *pMutex, int inicio, bool con_espera) {
+    int espera = int_clock_counter - inicio;
+
+    pMutex->estad.adquisiciones++;
+    if (!con_espera)
+        return;
+    pMutex->estad.con_espera++;
+    pMutex->estad.espera_total += espera;
+    if (espera > pMutex->estad.espera_max)
+        pMutex->estad.espera_max = espera;
+}
+
+void adquirirMutex(mutex *pMutex) {
+    adquirirMutexHasta(pMutex, 0);
+}
+
+/*
+ * Deja abierto un mutex que el proceso actual tenia cerrado y despierta
+ * al primero de su cola de espera. Con la politica TRASPASO el mutex pasa
+ * directamente a ese proceso; si no, este vuelve a competir por el en
+ * adquirirMutex, y otro proceso que llegue antes puede quedarselo.
+ */
+void liberarMutex(mutex *pMutex) {
+    BCP *proc = despertarPrimero(pMutex);
+    int retencion = int_clock_counter - pMutex->cerrado_desde;
+
+    pMutex->estad.retencion_total += retencion;
+    if (retencion > pMutex->estad.retencion_max)
+        pMutex->estad.retencion_max = retencion;
+
+    pMutex->proceso_bloqueado = -1;
+    pMutex->num_bloqueos = 0;
+    if (proc != NULL && (pMutex->tipo & TRASPASO)) {
+        pMutex->proceso_bloqueado = proc->id;
+        pMutex->num_bloqueos = 1;
+        pMutex->cerrado_desde = int_clock_counter;
+    } else
+        notificarEventos();
+}
+
+/*
+ * Copia en estad las estadisticas del mutex junto con su estado actual
+ */
+void leerEstadMutex(mutex *pMutex, struct estad_mutex *estad) {
+    BCP *proc;
+
+    *estad = pMutex->estad;
+    strcpy(estad->nombre, pMutex->nombre);
+    estad->propietario = pMutex->proceso_bloqueado;
+    estad->esperando = 0;
+    for (proc = pMutex->esperando.primero; proc != NULL; proc = proc->siguiente)
+        estad->esperando++;
+}
+
+/*
+ * Suma las estadisticas del mutex a las de los mutex eliminados con su
+ * mismo nombre. La ultima entrada se reserva para "(otros)", donde se
+ * acumulan los nombres que ya no caben.
+ */
+void acumularEstadMutex(mutex *pMutex) {
+    struct estad_mutex *acum;
+    int con_nombre = num_estad_cerrados < NUM_ESTAD_CERRADOS ?
+                     num_estad_cerrados : NUM_ESTAD_CERRADOS - 1;
+    int i;
+
+    for (i = 0; i < con_nombre; i++)
+        if (strcmp(estad_cerrados[i].nombre, pMutex->nombre) == 0)
+            break;
+    if (i == con_nombre) {
+        if (con_nombre < NUM_ESTAD_CERRADOS - 1) {
+            num_estad_cerrados++;
+            strcpy(estad_cerrados[i].nombre, pMutex->nombre);
+        } else {
+            i = NUM_ESTAD_CERRADOS - 1;
+            if (num_estad_cerrados < NUM_ESTAD_CERRADOS) {
+                num_estad_cerrados = NUM_ESTAD_CERRADOS;
+                strcpy(estad_cerrados[i].nombre, "(otros)");
+            }
+        }
+    }
+    acum = &estad_cerrados[i];
+    acum->adquisiciones += pMutex->estad.adquisiciones;
+    acum->con_espera += pMutex->estad.con_espera;
+    acum->desistidos += pMutex->estad.desistidos;
+    acum->espera_total += pMutex->estad.espera_total;
+    if (pMutex->estad.espera_max > acum->espera_max)
+        acum->espera_max = pMutex->estad.espera_max;
+    acum->retencion_total += pMutex->estad.retencion_total;
+    if (pMutex->estad.retencion_max > acum->retencion_max)
+        acum->retencion_max = pMutex->estad.retencion_max;
+    acum->propietario = -1;
+}
+
+/*
+ * Cede el cerrojo de lectura/escritura, ya libre, al primer escritor que
+ * espera. Devuelve false si no habia ninguno.
+ */
+bool cederEscritor(mutex *pMutex) {
+    BCP *proc = despertarPrimero(pMutex);
+
+    if (proc == NULL)
+        return false;
+    pMutex->proceso_bloqueado = proc->id;
+    return true;
+}
+
+/*
+ * Concede el lock de lectura a todos los lectores que esperan
+ */
+void despertarLectores(mutex *pMutex) {
+    pMutex->num_lectores += despertarTodos(&(pMutex->esperando_lect));
+}
+
+/*
+ * Suelta un lock de lectura. El ultimo lector cede el cerrojo al primer
+ * escritor que espera.
+ */
+void liberarLectura(mutex *pMutex) {
+    if (--pMutex->num_lectores == 0)
+        cederEscritor(pMutex);
+}
+
+/*
+ * Suelta el lock de escritura. Con LECTESC_EQUITATIVO pasan primero todos
+ * los lectores que esperan; con LECTESC_PREF_ESCRITOR, el siguiente
+ * escritor, y los lectores solo si no queda ninguno.
+ */
+void liberarEscritura(mutex *pMutex) {
+    pMutex->proceso_bloqueado = -1;
+    if ((pMutex->tipo & LECTESC_EQUITATIVO) && pMutex->esperando_lect.primero != NULL)
+        despertarLectores(pMutex);
+    else if (!cederEscritor(pMutex))
+        despertarLectores(pMutex);
+}
+
+/*
+ * Quita un participante de la barrera: ya no se espera su llegada ni en
+ * esta fase ni en las siguientes. Si era el unico que faltaba, los que
+ * esperan pasan la fase.
+ */
+static void abandonarBarrera(mutex *barrera) {
+    barrera->tipo--;
+    if (--barrera->valor > 0)
+        return;
+    barrera->valor = barrera->tipo;
+    despertarTodos(&(barrera->esperando));
+}
+
+/*
+ * Cierra un descriptor del proceso actual sobre el objeto: si es un mutex
+ * o un cerrojo de lectura/escritura que tenia cerrado lo libera, junto
+ * con los locks de lectura que retuviera por ese descriptor. Si es el de
+ * un participante de una barrera, deja de contarlo. Si era el ultimo
+ * proceso que lo tenia abierto lo elimina.
+ */
+void cerrarObjeto(mutex *pMutex, int lecturas) {
+    if (pMutex->clase == CLASE_MUTEX && pMutex->proceso_bloqueado == p_proc_actual->id)
+        liberarMutex(pMutex);
+    if (pMutex->clase == CLASE_LECTESC) {
+        if (pMutex->proceso_bloqueado == p_proc_actual->id)
+            liberarEscritura(pMutex);
+        while (lecturas-- > 0)
+            liberarLectura(pMutex);
+    }
+    if (pMutex->clase == CLASE_BARRERA && lecturas > 0)
+        abandonarBarrera(pMutex);
+    if (--pMutex->num_procesos > 0)
+        return;
+
+    if (pMutex->clase == CLASE_MUTEX)
+        acumularEstadMutex(pMutex);
+    if (pMutex->clase == CLASE_COLA)
+        diferir_memoria(pMutex->mensajes);
+    if (pMutex->clase == CLASE_SEGMENTO)
+        diferir_memoria(pMutex->memoria);
+    eliminar_mutex(pMutex->index);
+    cont_mutex--;
+}
+
+/*
+ * Devuelve el mutex con identificador mutex_id o NULL si ya no existe.
+ * El identificador lleva en sus bits bajos la entrada de tabla_mutex y en
+ * los altos la generacion de esa entrada, de modo que un identificador
+ * obsoleto de un mutex eliminado no coincide con el que ocupe su entrada.
+ */
+mutex *getMutex(int mutex_id) {
+    mutex *pMutex;
+
+    if (mutex_id < 0 || (mutex_id & MASCARA_SLOT_MUT) >= tam_tabla_mutex)
+        return NULL;
+    pMutex = tabla_mutex[mutex_id & MASCARA_SLOT_MUT].pMutex;
+    if (pMutex == NULL || pMutex->index != mutex_id)
+        return NULL;
+    return pMutex;
+}
+
+/*
+ * Deja libres todos los descriptores del proceso. La primera vez reserva
+ * su tabla con NUM_MUT_PROC descriptores; despues conserva la que tenga,
+ * que se reutiliza al ocupar otro proceso la misma entrada de tabla_procs.
+ */
+int iniciarDescriptores(BCP *p_proc) {
+    int i;
+
+    if (p_proc->tam_desc == 0) {
+        p_proc->mutexList = realloc(p_proc->mutexList, NUM_MUT_PROC * sizeof(int));
+        p_proc->lecturas = realloc(p_proc->lecturas, NUM_MUT_PROC * sizeof(int));
+        p_proc->desc_libres = realloc(p_proc->desc_libres, sizeof(unsigned long));
+        if (p_proc->mutexList == NULL || p_proc->lecturas == NULL
+            || p_proc->desc_libres == NULL)
+            return -1;
+        p_proc->tam_desc = NUM_MUT_PROC;
+    }
+    for (i = 0; i < p_proc->tam_desc; i++) {
+        p_proc->mutexList[i] = -1;
+        p_proc->lecturas[i] = 0;
+    }
+    p_proc->resumen_desc = 0;
+    for (i = 0; i * BITS_PALABRA < p_proc->tam_desc; i++) {
+        int bits = p_proc->tam_desc - i * BITS_PALABRA;
+
+        p_proc->desc_libres[i] = bits >= BITS_PALABRA ? ~0UL : (1UL << bits) - 1;
+        p_proc->resumen_desc |= 1UL << i;
+    }
+    p_proc->nMutex = 0;
+    return 0;
+}
+
+/*
+ * Duplica la tabla de descriptores del proceso actual, hasta MAX_DESC_PROC
+ */
+int crecerDescriptores() {
+    BCP *p = p_proc_actual;
+    int nuevo_tam = 2 * p->tam_desc;
+    int *objetos, *lecturas;
+    unsigned long *libres;
+    int i;
+
+    if (nuevo_tam > MAX_DESC_PROC)
+        return -1;
+    objetos = realloc(p->mutexList, nuevo_tam * sizeof(int));
+    if (objetos == NULL)
+        return -1;
+    p->mutexList = objetos;
+    lecturas = realloc(p->lecturas, nuevo_tam * sizeof(int));
+    if (lecturas == NULL)
+        return -1;
+    p->lecturas = lecturas;
+    libres = realloc(p->desc_libres,
+                     ((nuevo_tam + BITS_PALABRA - 1) / BITS_PALABRA) * sizeof(unsigned long));
+    if (libres == NULL)
+        return -1;
+    p->desc_libres = libres;
+
+    for (i = p->tam_desc; i < nuevo_tam; i++) {
+        int palabra = i / BITS_PALABRA;
+
+        if (i % BITS_PALABRA == 0)
+            p->desc_libres[palabra] = 0;
+        p->mutexList[i] = -1;
+        p->lecturas[i] = 0;
+        p->desc_libres[palabra] |= 1UL << (i % BITS_PALABRA);
+        p->resumen_desc |= 1UL << palabra;
+    }
+    p->tam_desc = nuevo_tam;
+    return 0;
+}
+
+/*
+ * Reserva el descriptor libre mas bajo del proceso actual, haciendo
+ * crecer su tabla si no queda ninguno. El resumen indica que palabras del
+ * mapa tienen algun descriptor libre, de modo que la busqueda es de
+ * tiempo constante.
+ */
+int reservarDescriptor() {
+    BCP *p = p_proc_actual;
+    int palabra, bit;
+
+    if (p->resumen_desc == 0 && crecerDescriptores() < 0)
+        return -1;
+    palabra = __builtin_ctzl(p->resumen_desc);
+    bit = __builtin_ctzl(p->desc_libres[palabra]);
+    p->desc_libres[palabra] &= ~(1UL << bit);
+    if (p->desc_libres[palabra] == 0)
+        p->resumen_desc &= ~(1UL << palabra);
+    p->nMutex++;
+    return palabra * BITS_PALABRA + bit;
+}
+
+void liberarDescriptor(int descriptor) {
+    BCP *p = p_proc_actual;
+    int palabra = descriptor / BITS_PALABRA;
+
+    p->mutexList[descriptor] = -1;
+    p->lecturas[descriptor] = 0;
+    p->desc_libres[palabra] |= 1UL << (descriptor % BITS_PALABRA);
+    p->resumen_desc |= 1UL << palabra;
+    p->nMutex--;
+}
+
+bool verificaCondiciones(const char *nombre) {
+
+    return strlen(nombre) <= MAX_NOM_MUT
+           && !nombreMutexRepetido(nombre);
+}
+
+bool nombreMutexRepetido(const char *nombre) {
+    return buscarMutexPorNombre(nombre) != NULL;
+}
+
+/*
+ * Tabla hash de nombres de mutex con direccionamiento abierto y sondeo
+ * lineal. Las entradas borradas se marcan con HASH_MUT_BORRADO para no
+ * cortar las secuencias de sondeo de otros nombres. Borrar no reserva ni
+ * libera memoria porque se hace tambien desde liberar_proceso; las marcas
+ * se compactan al crear el siguiente mutex.
+ */
+static unsigned int hashNombre(const char *nombre) {
+    unsigned int hash = 2166136261u; /* FNV-1a */
+    int i;
+
+    for (i = 0; i < MAX_NOM_MUT && nombre[i] != '\0'; i++) {
+        hash ^= (unsigned char) nombre[i];
+        hash *= 16777619u;
+    }
+    return hash & (tam_hash_mutex - 1);
+}
+
+mutex *buscarMutexPorNombre(const char *nombre) {
+    unsigned int pos = hashNombre(nombre);
+    int i;
+
+    for (i = 0; i < tam_hash_mutex && hash_mutex[pos] != NULL; i++) {
+        if (hash_mutex[pos] != HASH_MUT_BORRADO
+            && strcmp(hash_mutex[pos]->nombre, nombre) == 0)
+            return hash_mutex[pos];
+        pos = (pos + 1) & (tam_hash_mutex - 1);
+    }
+    return NULL;
+}
+
+void insertarHashMutex(mutex *pMutex) {
+    unsigned int pos = hashNombre(pMutex->nombre);
+
+    while (hash_mutex[pos] != NULL && hash_mutex[pos] != HASH_MUT_BORRADO)
+        pos = (pos + 1) & (tam_hash_mutex - 1);
+    if (hash_mutex[pos] == HASH_MUT_BORRADO)
+        num_borrados_hash--;
+    hash_mutex[pos] = pMutex;
+}
+
+void eliminarHashMutex(mutex *pMutex) {
+    unsigned int pos = hashNombre(pMutex->nombre);
+
+    while (hash_mutex[pos] != pMutex)
+        pos = (pos + 1) & (tam_hash_mutex - 1);
+    hash_mutex[pos] = HASH_MUT_BORRADO;
+    num_borrados_hash++;
+
+    /* si la secuencia termina aqui, las marcas del final ya no hacen falta */
+    while (hash_mutex[pos] == HASH_MUT_BORRADO
+           && hash_mutex[(pos + 1) & (tam_hash_mutex - 1)] == NULL) {
+        hash_mutex[pos] = NULL;
+        num_borrados_hash--;
+        pos = (pos - 1) & (tam_hash_mutex - 1);
+    }
+}
+
+/*
+ * Sustituye la tabla hash por una de tam entradas, potencia de 2, con
+ * los mutex de tabla_mutex y sin marcas de borrado
+ */
+int reconstruirHashMutex(int tam) {
+    mutex **nueva = calloc(tam, sizeof(mutex *));
+    int i;
+
+    if (nueva == NULL)
+        return -1;
+    free(hash_mutex);
+    hash_mutex = nueva;
+    tam_hash_mutex = tam;
+    num_borrados_hash = 0;
+    for (i = 0; i < tam_tabla_mutex; i++)
+        if (tabla_mutex[i].pMutex != NULL)
+            insertarHashMutex(tabla_mutex[i].pMutex);
+    return 0;
+}
+
+/*
+ * Amplia la tabla de mutex hasta tam entradas, que quedan libres con
+ * generacion 0, y la tabla hash en proporcion
+ */
+int crecerTablaMutex(int tam) {
+    entrada_mutex *tabla;
+    int *slots;
+    int tam_hash = tam_hash_mutex > 0 ? tam_hash_mutex : 1;
+    int i;
+
+    tabla = realloc(tabla_mutex, tam * sizeof(entrada_mutex));
+    if (tabla == NULL)
+        return -1;
+    tabla_mutex = tabla;
+    slots = realloc(slots_libres_mutex, tam * sizeof(int));
+    if (slots == NULL)
+        return -1;
+    slots_libres_mutex = slots;
+
+    /* se apilan en orden inverso para que salgan primero las mas bajas */
+    for (i = tam - 1; i >= tam_tabla_mutex; i--) {
+        tabla_mutex[i].pMutex = NULL;
+        tabla_mutex[i].generacion = 0;
+        slots_libres_mutex[num_slots_libres_mutex++] = i;
+    }
+    tam_tabla_mutex = tam;
+
+    while (tam_hash < 2 * tam)
+        tam_hash *= 2;
+    if (tam_hash != tam_hash_mutex)
+        return reconstruirHashMutex(tam_hash);
+    return 0;
+}
+
+/*
+ * Inicia la tabla de mutex con NUM_MUT entradas libres
+ */
+void iniciarTablaMutex() {
+    if (crecerTablaMutex(NUM_MUT) < 0)
+        panico("no hay memoria para la tabla de mutex");
+}
+
+void eliminar_mutex(int mutex_id) {
+    int slot = mutex_id & MASCARA_SLOT_MUT;
+    mutex *pMutex = tabla_mutex[slot].pMutex;
+
+    tabla_mutex[slot].pMutex = NULL;
+    eliminarHashMutex(pMutex);
+    liberar_objeto(&cache_mutex, pMutex);
+    tabla_mutex[slot].generacion = (tabla_mutex[slot].generacion + 1) & MASCARA_GEN_MUT;
+    slots_libres_mutex[num_slots_libres_mutex++] = slot;
+}
+
+int crearMutex(char *nombre, int clase, int tipo) {
+    /* demasiadas marcas alargan las busquedas: se reconstruye la tabla
+       antes de anotar el nuevo, que se inserta despues */
+    if (num_borrados_hash > tam_hash_mutex / 4)
+        reconstruirHashMutex(tam_hash_mutex);
+    if (num_slots_libres_mutex == 0) {
+        int tam = 2 * tam_tabla_mutex;
+
+        if (crecerTablaMutex(tam < MAX_MUT ? tam : MAX_MUT) < 0)
+            return -1;
+    }
+    mutex *nuevo_mutex = reservar_objeto(&cache_mutex);
+    if (nuevo_mutex == NULL)
+        return -1;
+    int slot = slots_libres_mutex[--num_slots_libres_mutex];
+    nuevo_mutex->index = (tabla_mutex[slot].generacion << BITS_SLOT_MUT) | slot;
     strcpy(nuevo_mutex->nombre, nombre);
-    printf("******************** copiado nombre %s\n", nuevo_mutex->nombre);
+    nuevo_mutex->clase = clase;
     nuevo_mutex->tipo = tipo;
-    printf("******************** del tipo %d\n", tipo);
+    nuevo_mutex->valor = 0;
     nuevo_mutex->num_procesos = 1;
-    printf("********************  incrementado numero de procesos %d\n", nuevo_mutex->num_procesos);
-    nuevo_mutex->proceso_bloqueado = p_proc_actual->id;
-    printf("******************** INSERTAMOS MUTEX EN LISTA\n");
-    insertar_mutex(&lista_mutex, nuevo_mutex);
+    nuevo_mutex->proceso_bloqueado = -1;
+    nuevo_mutex->num_bloqueos = 0;
+    nuevo_mutex->num_lectores = 0;
+    nuevo_mutex->esperando.primero = NULL;
+    nuevo_mutex->esperando.ultimo = NULL;
+    nuevo_mutex->esperando_lect.primero = NULL;
+    nuevo_mutex->esperando_lect.ultimo = NULL;
+    nuevo_mutex->cerrado_desde = 0;
+    memset(&(nuevo_mutex->estad), 0, sizeof(nuevo_mutex->estad));
+    nuevo_mutex->mensajes = NULL;
+    nuevo_mutex->memoria = NULL;
+    tabla_mutex[slot].pMutex = nuevo_mutex;
+    insertarHashMutex(nuevo_mutex);
+    return nuevo_mutex->index;
 }
 
 /*
@@ -937,6 +3825,14 @@ int main() {
     iniciar_cont_teclado();        /* inici cont. teclado */
 
     iniciar_tabla_proc();        /* inicia BCPs de tabla de procesos */
+    iniciarBufferTerminal(TAM_TERMINAL); /* inicia buffer del terminal */
+    iniciarConsola(TAM_CONSOLA);   /* inicia cola de salida de la consola */
+    iniciar_cache(&cache_mutex, "mutex", sizeof(mutex), NUM_MUT);
+    iniciar_cache(&cache_tuberias, "tuberias", sizeof(tuberia), 1);
+    iniciar_cache(&cache_ficheros, "ficheros", sizeof(fichero), MAX_FD_PROC);
+    iniciar_cache(&cache_imagenes, "imagenes", sizeof(recursos_imagen), 1);
+    iniciarCachePaginas();       /* inicia cache de paginas de ficheros */
+    iniciarTablaMutex();         /* inicia tabla de mutex */
 
     /* crea proceso inicial */
     if (crear_tarea((void *) "init") < 0)
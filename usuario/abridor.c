@@ -35,18 +35,17 @@ int main(){
 	if (abrir_mutex("m4")<0)
 		printf("error abriendo m4. NO DEBE SALIR\n");
 
-	/* Error: ha agotado los descriptores */
-	if (abrir_mutex("m5")>0)
-		printf("error abriendo m5. DEBE SALIR\n");
+	/* la tabla de descriptores crece: no se agotan */
+	if (abrir_mutex("m5")<0)
+		printf("error abriendo m5. NO DEBE SALIR\n");
 
 	/* libera un descriptor de mutex (m1) */
     printf("\n-----------------------------CERRAMOS-----------------------------\n");
 	cerrar_mutex(desc);
 
-	/* Agotado num mutex del sistema. Debe bloquearse */
+	/* la tabla de mutex del sistema crece: no se bloquea */
 	if (crear_mutex("m17", 0)<0)
 		printf("error creando m17. NO DEBE SALIR\n");
-	/* se desbloquear� cuando se elimine m1 */
 
 	/* intenta crear el mismo mutex: devuelve un error porque ya existe */
 	if (crear_mutex("m17", 0)<0)
@@ -0,0 +1,37 @@
+/*
+ * usuario/compartidor.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que lanza prueba_segmento. Proyecta el segmento
+ * sprueba, muestra su texto y contesta en la segunda mitad. Termina sin
+ * desproyectarlo para probar que se deshace al terminar el proceso.
+ */
+
+#include <string.h>
+#include "servicios.h"
+
+int main(){
+	char *p;
+	int s, m, tam;
+
+	printf("compartidor: comienza\n");
+
+	s = abrir_segmento("sprueba");
+	p = proyectar(s, &tam);
+	if (p == NULL)
+		printf("error proyectando el segmento. NO DEBE APARECER\n");
+	printf("compartidor: segmento de %d bytes: %s\n", tam, p);
+	strcpy(p + tam / 2, "hola desde compartidor");
+	cerrar_segmento(s);
+
+	m = abrir_sem("ssegm");
+	sem_senalar(m);
+	cerrar_sem(m);
+
+	printf("compartidor: termina\n");
+	return 0;
+}
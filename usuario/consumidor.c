@@ -0,0 +1,39 @@
+/*
+ * usuario/consumidor.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba_tuberia lanza con una tuberia heredada
+ * en los descriptores 0 (lectura) y 1 (escritura). Lee hasta el fin de
+ * los datos y comprueba su contenido.
+ */
+
+#include "servicios.h"
+
+int main(){
+	char buf[64];
+	int n, i, total = 0, lecturas = 0, errores = 0;
+
+	printf("consumidor: comienza\n");
+
+	/* el extremo de escritura heredado impediria ver el fin de datos */
+	cerrar_fd(1);
+
+	while ((n = leer_fd(0, buf, sizeof(buf))) > 0) {
+		for (i = 0; i < n; i++)
+			if (buf[i] != 'a' + (total + i) % 100 % 26)
+				errores++;
+		total += n;
+		lecturas++;
+	}
+	printf("consumidor: recibidos %d bytes en %d lecturas, %d erroneos\n",
+		total, lecturas, errores);
+	printf("DEBEN SER 10000 BYTES Y 0 ERRONEOS\n");
+	cerrar_fd(0);
+
+	printf("consumidor: termina\n");
+	return 0;
+}
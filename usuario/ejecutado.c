@@ -0,0 +1,24 @@
+/*
+ * usuario/ejecutado.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba_ejecutar lanza mediante la llamada
+ * ejecutar. Usa el descriptor de mutex heredado de la imagen anterior.
+ */
+
+#include "servicios.h"
+
+int main(){
+
+	printf("ejecutado (%d): comienza con la misma id\n", obtener_id_pr());
+
+	if (cerrar_mutex(0) < 0)
+		printf("error cerrando el descriptor heredado. NO DEBE APARECER\n");
+
+	printf("ejecutado (%d): termina\n", obtener_id_pr());
+	return 0;
+}
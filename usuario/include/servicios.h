@@ -19,9 +19,21 @@
 #ifndef SERVICIOS_H
 #define SERVICIOS_H
 
+#include "llamsis.h" /* constantes compartidas con el kernel */
+
 #define NO_RECURSIVO 0
 #define RECURSIVO 1
 
+#define TRASPASO 2 /* unlock cede la propiedad al primero que espera */
+
+/* politicas de los cerrojos de lectura/escritura */
+#define LECTESC_PREF_ESCRITOR 0 /* al liberar se prefiere al siguiente escritor */
+#define LECTESC_EQUITATIVO 1 /* al liberar un escritor pasan los lectores que esperan */
+
+/* modos del terminal */
+#define MODO_CRUDO 0 /* cada caracter se entrega al llegar */
+#define MODO_CANONICO 1 /* se entregan lineas completas ya editadas */
+
 /* Evita el uso del printf de la bilioteca est�ndar */
 #define printf escribirf
 
@@ -30,9 +42,89 @@ struct tiempos_ejec {
     int sistema;
 };
 
-/* Funcion de biblioteca */
+/* Estadisticas de uso de un mutex, en ticks de reloj */
+struct estad_mutex {
+    char nombre[MAX_NOM_MUT + 1];
+    int adquisiciones;          /* locks obtenidos, sin contar los recursivos */
+    int con_espera;             /* locks que tuvieron que bloquearse */
+    int desistidos;             /* trylock ocupados y lock_timeout vencidos */
+    int espera_total;
+    int espera_max;
+    int retencion_total;        /* tiempo con el mutex cerrado */
+    int retencion_max;
+    int propietario;            /* proceso que lo tiene cerrado, -1 si ninguno */
+    int esperando;              /* procesos bloqueados en el */
+};
+
+/* Fuente de eventos de esperar_eventos: se rellenan tipo e id (el
+   descriptor del mutex) y el kernel pone listo a 1 si esta preparada */
+#define EV_TERMINAL 0 /* hay caracteres que leer */
+#define EV_MUTEX 1    /* el mutex esta abierto */
+
+struct evento {
+    int tipo;
+    int id;
+    int listo;
+};
+
+/* Prioridades de los mensajes de las colas, 0 la menos urgente */
+#define NUM_PRIO_COLA 8
+
+/* Mensaje de recibir_lote: se rellenan buf y tam y el kernel pone la
+   longitud y la prioridad del mensaje recibido */
+struct mensaje {
+    char *buf;
+    int tam;
+    int lon;
+    int prioridad;
+};
+
+/* Tamano maximo de un segmento de memoria compartida */
+#define MAX_TAM_SEG (1 << 20)
+
+/* Modo de abrir_fichero */
+#define FICH_LECTURA 1
+#define FICH_ESCRITURA 2
+#define FICH_CREAR 4    /* lo crea si no existe */
+#define FICH_TRUNCAR 8  /* lo deja vacio */
+
+/* Origen del desplazamiento de posicionar */
+#define POS_INICIO 0
+#define POS_ACTUAL 1
+#define POS_FINAL 2
+
+/* Contadores de la cache de paginas de los ficheros */
+struct estad_cache {
+    unsigned int aciertos;      /* paginas encontradas en la cache */
+    unsigned int fallos;        /* paginas pedidas que no estaban */
+    unsigned int anticipadas;   /* paginas leidas por adelantado */
+    unsigned int lecturas;      /* lecturas del anfitrion */
+    unsigned int escrituras;    /* escrituras en el anfitrion */
+};
+
+/* Cerrojo de biblioteca sobre futex: solo entra en el kernel si hay
+   competencia. Estado 0 abierto, 1 cerrado, 2 cerrado con esperas */
+typedef struct {
+    volatile int estado;
+} cerrojo;
+
+#define CERROJO_INICIAL {0}
+
+/* Modos del buffer de salida de escribirf_buf. printf no usa el buffer;
+   el programa que lo quiera debe llamar a escribirf_buf */
+#define BUF_LINEA 0    /* se vacia al escribir un fin de linea */
+#define BUF_COMPLETO 1 /* se vacia al llenarse */
+#define SIN_BUF 2      /* cada llamada escribe directamente */
+
+/* Funciones de biblioteca */
 int escribirf(const char *formato, ...);
 
+int escribirf_buf(const char *formato, ...);
+
+int modo_buffer(int modo);
+
+int vaciar();
+
 /* Llamadas al sistema proporcionadas */
 int crear_proceso(char *prog);
 
@@ -40,6 +132,22 @@ int terminar_proceso();
 
 int escribir(char *texto, unsigned int longi);
 
+int escribirv(struct fragmento *fragmentos, int n);
+
+int crear_tuberia(int fds[2]);
+
+int leer_fd(int fd, char *buf, int n);
+
+int escribir_fd(int fd, char *buf, int n);
+
+int cerrar_fd(int fd);
+
+int abrir_fichero(char *nombre, int modo);
+
+int posicionar(int fd, int desp, int origen);
+
+int estad_cache(struct estad_cache *estad);
+
 int obtener_id_pr();
 
 int dormir(unsigned int segundos);
@@ -54,9 +162,116 @@ int lock(unsigned int mutexid);
 
 int unlock(unsigned int mutexid);
 
+int trylock(unsigned int mutexid);
+
+int lock_timeout(unsigned int mutexid, unsigned int ms);
+
+int estadisticas_mutex(struct estad_mutex *tabla, int max);
+
 int cerrar_mutex(unsigned int mutexid);
 
 int leer_caracter();
 
+int leer(char *buf, int n, int min);
+
+int modo_terminal(int modo);
+
+int no_bloqueante(int activar);
+
+int esperar_eventos(struct evento *eventos, int n, int ms);
+
+int crear_hilo(int (*funcion)(void *), void *arg);
+
+int terminar_hilo(int valor);
+
+int esperar_hilo(int id);
+
+int ejecutar(char *prog);
+
+int futex_esperar(int *dir, int valor);
+
+int futex_despertar(int *dir, int n);
+
+int crear_sem(char *nombre, int valor);
+
+int abrir_sem(char *nombre);
+
+int sem_esperar(unsigned int semid);
+
+int sem_senalar(unsigned int semid);
+
+int cerrar_sem(unsigned int semid);
+
+int crear_cond(char *nombre);
+
+int abrir_cond(char *nombre);
+
+int cond_esperar(unsigned int condid, unsigned int mutexid);
+
+int cond_senalar(unsigned int condid);
+
+int cond_difundir(unsigned int condid);
+
+int cerrar_cond(unsigned int condid);
+
+int crear_lectesc(char *nombre, int politica);
+
+int abrir_lectesc(char *nombre);
+
+int lock_lectura(unsigned int lectescid);
+
+int lock_escritura(unsigned int lectescid);
+
+int unlock_lectesc(unsigned int lectescid);
+
+int cerrar_lectesc(unsigned int lectescid);
+
+int crear_barrera(char *nombre, int n);
+
+int abrir_barrera(char *nombre);
+
+int barrera_esperar(unsigned int barreraid);
+
+int cerrar_barrera(unsigned int barreraid);
+
+int crear_cuenta(char *nombre, int n);
+
+int abrir_cuenta(char *nombre);
+
+int cuenta_descontar(unsigned int cuentaid);
+
+int cuenta_esperar(unsigned int cuentaid);
+
+int cerrar_cuenta(unsigned int cuentaid);
+
+int crear_cola(char *nombre, int max_mensajes, int tam_max);
+
+int abrir_cola(char *nombre);
+
+int enviar(unsigned int colaid, char *msg, int lon, int prioridad, int ms);
+
+int recibir(unsigned int colaid, char *buf, int tam, int *prioridad, int ms);
+
+int recibir_lote(unsigned int colaid, struct mensaje *mensajes, int n, int ms);
+
+int cerrar_cola(unsigned int colaid);
+
+int crear_segmento(char *nombre, int tam);
+
+int abrir_segmento(char *nombre);
+
+void *proyectar(unsigned int segid, int *tam);
+
+int desproyectar(void *dir);
+
+int cerrar_segmento(unsigned int segid);
+
+/* Funciones de biblioteca sobre futex */
+void iniciar_cerrojo(cerrojo *c);
+
+void echar_cerrojo(cerrojo *c);
+
+void quitar_cerrojo(cerrojo *c);
+
 #endif /* SERVICIOS_H */
 
@@ -91,6 +91,101 @@ ALGO COMENTE ESTA PARTE Y DESCOMENTE LA PRUEBA CORRESPONDIENTE */
         printf("Error creando prueba_term\n");*/
 
 
+/* PRUEBA DE HILOS
+    if (crear_proceso("prueba_hilos") < 0)
+        printf("Error creando prueba_hilos\n");*/
+
+
+/* PRUEBA DE LA LLAMADA EJECUTAR
+    if (crear_proceso("prueba_ejecutar") < 0)
+        printf("Error creando prueba_ejecutar\n");*/
+
+
+/* PRUEBA DE LA POLITICA TRASPASO DE LOS MUTEX
+    if (crear_proceso("prueba_traspaso") < 0)
+        printf("Error creando prueba_traspaso\n");*/
+
+
+/* PRUEBA DEL CERROJO SOBRE FUTEX
+    if (crear_proceso("prueba_futex") < 0)
+        printf("Error creando prueba_futex\n");*/
+
+
+/* PRUEBA DE SEMAFOROS Y VARIABLES CONDICION
+    if (crear_proceso("prueba_sincro") < 0)
+        printf("Error creando prueba_sincro\n");*/
+
+
+/* PRUEBA DE LOS CERROJOS DE LECTURA/ESCRITURA
+    if (crear_proceso("prueba_lectesc") < 0)
+        printf("Error creando prueba_lectesc\n");*/
+
+
+/* PRUEBA DE BARRERAS Y CUENTAS ATRAS
+    if (crear_proceso("prueba_barrera") < 0)
+        printf("Error creando prueba_barrera\n");*/
+
+
+/* PRUEBA DE TRYLOCK Y LOCK_TIMEOUT
+    if (crear_proceso("prueba_timeout") < 0)
+        printf("Error creando prueba_timeout\n");*/
+
+
+/* PRUEBA DE LAS ESTADISTICAS DE LOS MUTEX
+    if (crear_proceso("prueba_estad") < 0)
+        printf("Error creando prueba_estad\n");*/
+
+
+/* PRUEBA DE MUCHOS MUTEX ABIERTOS POR UN PROCESO
+    if (crear_proceso("prueba_muchos") < 0)
+        printf("Error creando prueba_muchos\n");*/
+
+
+/* PRUEBA DE LECTURA DE BLOQUES DEL TERMINAL
+    if (crear_proceso("prueba_leer") < 0)
+        printf("Error creando prueba_leer\n");*/
+
+
+/* PRUEBA DEL MODO CANONICO DEL TERMINAL
+    if (crear_proceso("prueba_canonico") < 0)
+        printf("Error creando prueba_canonico\n");*/
+
+
+/* PRUEBA DE ESPERAR_EVENTOS Y LECTURAS NO BLOQUEANTES
+    if (crear_proceso("prueba_eventos") < 0)
+        printf("Error creando prueba_eventos\n");*/
+
+
+/* PRUEBA DE LA SALIDA CON BUFFER DE LA BIBLIOTECA
+    if (crear_proceso("prueba_buffer") < 0)
+        printf("Error creando prueba_buffer\n");*/
+
+
+/* PRUEBA DE LA ESCRITURA DE VARIOS FRAGMENTOS
+    if (crear_proceso("prueba_escribirv") < 0)
+        printf("Error creando prueba_escribirv\n");*/
+
+
+/* PRUEBA DE TUBERIAS ENTRE PROCESOS
+    if (crear_proceso("prueba_tuberia") < 0)
+        printf("Error creando prueba_tuberia\n");*/
+
+
+/* PRUEBA DE COLAS DE MENSAJES
+    if (crear_proceso("prueba_colas") < 0)
+        printf("Error creando prueba_colas\n");*/
+
+
+/* PRUEBA DE MEMORIA COMPARTIDA
+    if (crear_proceso("prueba_segmento") < 0)
+        printf("Error creando prueba_segmento\n");*/
+
+
+/* PRUEBA DE FICHEROS Y CACHE DE PAGINAS
+    if (crear_proceso("prueba_ficheros") < 0)
+        printf("Error creando prueba_ficheros\n");*/
+
+
     printf("init: termina\n");
     return 0;
 }
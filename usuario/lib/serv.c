@@ -16,6 +16,9 @@
  *
  */
 
+#include <stdarg.h>
+#include <stdio.h>
+
 #include "llamsis.h"
 #include "servicios.h"
 
@@ -26,6 +29,18 @@
 
 int llamsis(int llamada, int nargs, ... /* args */);
 
+/* Rutina de arranque de los hilos: obtiene del kernel la funcion del hilo
+   y su argumento, la ejecuta y termina el hilo con el valor devuelto */
+
+static void inicio_hilo() {
+    void *datos[2];
+    int (*funcion)(void *);
+
+    llamsis(DATOS_HILO, 1, (long) datos);
+    funcion = (int (*)(void *)) datos[0];
+    terminar_hilo(funcion(datos[1]));
+}
+
 
 /*
  *
@@ -39,6 +54,7 @@ int crear_proceso(char *prog) {
 }
 
 int terminar_proceso() {
+    vaciar();
     return llamsis(TERMINAR_PROCESO, 0);
 }
 
@@ -46,6 +62,38 @@ int escribir(char *texto, unsigned int longi) {
     return llamsis(ESCRIBIR, 2, (long) texto, (long) longi);
 }
 
+int escribirv(struct fragmento *fragmentos, int n) {
+    return llamsis(ESCRIBIRV, 2, (long) fragmentos, (long) n);
+}
+
+int crear_tuberia(int fds[2]) {
+    return llamsis(CREAR_TUBERIA, 1, (long) fds);
+}
+
+int leer_fd(int fd, char *buf, int n) {
+    return llamsis(LEER_FD, 3, (long) fd, (long) buf, (long) n);
+}
+
+int escribir_fd(int fd, char *buf, int n) {
+    return llamsis(ESCRIBIR_FD, 3, (long) fd, (long) buf, (long) n);
+}
+
+int cerrar_fd(int fd) {
+    return llamsis(CERRAR_FD, 1, (long) fd);
+}
+
+int abrir_fichero(char *nombre, int modo) {
+    return llamsis(ABRIR_FICHERO, 2, (long) nombre, (long) modo);
+}
+
+int posicionar(int fd, int desp, int origen) {
+    return llamsis(POSICIONAR, 3, (long) fd, (long) desp, (long) origen);
+}
+
+int estad_cache(struct estad_cache *estad) {
+    return llamsis(ESTAD_CACHE, 1, (long) estad);
+}
+
 int obtener_id_pr() {
     return llamsis(OBTENER_ID_PR, 0);
 }
@@ -74,10 +122,342 @@ int unlock(unsigned int mutexid) {
     return llamsis(UNLOCK, 1, (long) mutexid);
 }
 
+int trylock(unsigned int mutexid) {
+    return llamsis(TRYLOCK, 1, (long) mutexid);
+}
+
+int lock_timeout(unsigned int mutexid, unsigned int ms) {
+    return llamsis(LOCK_TIMEOUT, 2, (long) mutexid, (long) ms);
+}
+
+int estadisticas_mutex(struct estad_mutex *tabla, int max) {
+    return llamsis(ESTAD_MUTEX, 2, (long) tabla, (long) max);
+}
+
 int cerrar_mutex(unsigned int mutexid) {
     return llamsis(CERRAR_MUTEX, 1, (long) mutexid);
 }
 
 int leer_caracter() {
     return llamsis(LEER_CARACTER, 0);
-}
\ No newline at end of file
+}
+
+int leer(char *buf, int n, int min) {
+    return llamsis(LEER, 3, (long) buf, (long) n, (long) min);
+}
+
+int modo_terminal(int modo) {
+    return llamsis(MODO_TERMINAL, 1, (long) modo);
+}
+
+int no_bloqueante(int activar) {
+    return llamsis(NO_BLOQUEANTE, 1, (long) activar);
+}
+
+int esperar_eventos(struct evento *eventos, int n, int ms) {
+    return llamsis(ESPERAR_EVENTOS, 3, (long) eventos, (long) n, (long) ms);
+}
+
+int crear_hilo(int (*funcion)(void *), void *arg) {
+    return llamsis(CREAR_HILO, 3, (long) inicio_hilo, (long) funcion, (long) arg);
+}
+
+int terminar_hilo(int valor) {
+    vaciar();
+    return llamsis(TERMINAR_HILO, 1, (long) valor);
+}
+
+int esperar_hilo(int id) {
+    return llamsis(ESPERAR_HILO, 1, (long) id);
+}
+
+int ejecutar(char *prog) {
+    return llamsis(EJECUTAR, 1, (long) prog);
+}
+
+int futex_esperar(int *dir, int valor) {
+    return llamsis(FUTEX_ESPERAR, 2, (long) dir, (long) valor);
+}
+
+int futex_despertar(int *dir, int n) {
+    return llamsis(FUTEX_DESPERTAR, 2, (long) dir, (long) n);
+}
+
+int crear_sem(char *nombre, int valor) {
+    return llamsis(CREAR_SEM, 2, (long) nombre, (long) valor);
+}
+
+int abrir_sem(char *nombre) {
+    return llamsis(ABRIR_SEM, 1, (long) nombre);
+}
+
+int sem_esperar(unsigned int semid) {
+    return llamsis(SEM_ESPERAR, 1, (long) semid);
+}
+
+int sem_senalar(unsigned int semid) {
+    return llamsis(SEM_SENALAR, 1, (long) semid);
+}
+
+int cerrar_sem(unsigned int semid) {
+    return llamsis(CERRAR_SEM, 1, (long) semid);
+}
+
+int crear_cond(char *nombre) {
+    return llamsis(CREAR_COND, 1, (long) nombre);
+}
+
+int abrir_cond(char *nombre) {
+    return llamsis(ABRIR_COND, 1, (long) nombre);
+}
+
+int cond_esperar(unsigned int condid, unsigned int mutexid) {
+    return llamsis(COND_ESPERAR, 2, (long) condid, (long) mutexid);
+}
+
+int cond_senalar(unsigned int condid) {
+    return llamsis(COND_SENALAR, 1, (long) condid);
+}
+
+int cond_difundir(unsigned int condid) {
+    return llamsis(COND_DIFUNDIR, 1, (long) condid);
+}
+
+int cerrar_cond(unsigned int condid) {
+    return llamsis(CERRAR_COND, 1, (long) condid);
+}
+
+int crear_lectesc(char *nombre, int politica) {
+    return llamsis(CREAR_LECTESC, 2, (long) nombre, (long) politica);
+}
+
+int abrir_lectesc(char *nombre) {
+    return llamsis(ABRIR_LECTESC, 1, (long) nombre);
+}
+
+int lock_lectura(unsigned int lectescid) {
+    return llamsis(LOCK_LECTURA, 1, (long) lectescid);
+}
+
+int lock_escritura(unsigned int lectescid) {
+    return llamsis(LOCK_ESCRITURA, 1, (long) lectescid);
+}
+
+int unlock_lectesc(unsigned int lectescid) {
+    return llamsis(UNLOCK_LECTESC, 1, (long) lectescid);
+}
+
+int cerrar_lectesc(unsigned int lectescid) {
+    return llamsis(CERRAR_LECTESC, 1, (long) lectescid);
+}
+
+int crear_barrera(char *nombre, int n) {
+    return llamsis(CREAR_BARRERA, 2, (long) nombre, (long) n);
+}
+
+int abrir_barrera(char *nombre) {
+    return llamsis(ABRIR_BARRERA, 1, (long) nombre);
+}
+
+int barrera_esperar(unsigned int barreraid) {
+    return llamsis(BARRERA_ESPERAR, 1, (long) barreraid);
+}
+
+int cerrar_barrera(unsigned int barreraid) {
+    return llamsis(CERRAR_BARRERA, 1, (long) barreraid);
+}
+
+int crear_cuenta(char *nombre, int n) {
+    return llamsis(CREAR_CUENTA, 2, (long) nombre, (long) n);
+}
+
+int abrir_cuenta(char *nombre) {
+    return llamsis(ABRIR_CUENTA, 1, (long) nombre);
+}
+
+int cuenta_descontar(unsigned int cuentaid) {
+    return llamsis(CUENTA_DESCONTAR, 1, (long) cuentaid);
+}
+
+int cuenta_esperar(unsigned int cuentaid) {
+    return llamsis(CUENTA_ESPERAR, 1, (long) cuentaid);
+}
+
+int cerrar_cuenta(unsigned int cuentaid) {
+    return llamsis(CERRAR_CUENTA, 1, (long) cuentaid);
+}
+
+int crear_cola(char *nombre, int max_mensajes, int tam_max) {
+    return llamsis(CREAR_COLA, 3, (long) nombre, (long) max_mensajes, (long) tam_max);
+}
+
+int abrir_cola(char *nombre) {
+    return llamsis(ABRIR_COLA, 1, (long) nombre);
+}
+
+int enviar(unsigned int colaid, char *msg, int lon, int prioridad, int ms) {
+    return llamsis(ENVIAR, 5, (long) colaid, (long) msg, (long) lon, (long) prioridad, (long) ms);
+}
+
+int recibir(unsigned int colaid, char *buf, int tam, int *prioridad, int ms) {
+    return llamsis(RECIBIR, 5, (long) colaid, (long) buf, (long) tam, (long) prioridad, (long) ms);
+}
+
+int recibir_lote(unsigned int colaid, struct mensaje *mensajes, int n, int ms) {
+    return llamsis(RECIBIR_LOTE, 4, (long) colaid, (long) mensajes, (long) n, (long) ms);
+}
+
+int cerrar_cola(unsigned int colaid) {
+    return llamsis(CERRAR_COLA, 1, (long) colaid);
+}
+
+int crear_segmento(char *nombre, int tam) {
+    return llamsis(CREAR_SEGMENTO, 2, (long) nombre, (long) tam);
+}
+
+int abrir_segmento(char *nombre) {
+    return llamsis(ABRIR_SEGMENTO, 1, (long) nombre);
+}
+
+/* La direccion no cabe en el valor de retorno de la llamada, que
+   devuelve el tamano del segmento */
+void *proyectar(unsigned int segid, int *tam) {
+    void *dir;
+    int n = llamsis(PROYECTAR, 2, (long) segid, (long) &dir);
+
+    if (n < 0)
+        return NULL;
+    if (tam != NULL)
+        *tam = n;
+    return dir;
+}
+
+int desproyectar(void *dir) {
+    return llamsis(DESPROYECTAR, 1, (long) dir);
+}
+
+int cerrar_segmento(unsigned int segid) {
+    return llamsis(CERRAR_SEGMENTO, 1, (long) segid);
+}
+
+
+/*
+ *
+ * Cerrojo sobre futex. Cerrar un cerrojo abierto y abrir uno sin esperas
+ * se resuelve con una operacion atomica sin llamada al sistema; solo
+ * con competencia se usa futex_esperar y futex_despertar.
+ *
+ */
+
+void iniciar_cerrojo(cerrojo *c) {
+    c->estado = 0;
+}
+
+void echar_cerrojo(cerrojo *c) {
+    int *dir = (int *) &c->estado;
+    int actual = __sync_val_compare_and_swap(dir, 0, 1);
+
+    if (actual == 0)
+        return;
+    /* marca que hay esperas antes de bloquearse, para que el que
+       lo tiene cerrado sepa que debe despertar a alguien */
+    if (actual != 2)
+        actual = __sync_lock_test_and_set(dir, 2);
+    while (actual != 0) {
+        futex_esperar(dir, 2);
+        actual = __sync_lock_test_and_set(dir, 2);
+    }
+}
+
+void quitar_cerrojo(cerrojo *c) {
+    int *dir = (int *) &c->estado;
+
+    if (__sync_fetch_and_sub(dir, 1) != 1) {
+        c->estado = 0;
+        futex_despertar(dir, 1);
+    }
+}
+
+
+/*
+ *
+ * Salida con buffer. escribirf_buf acumula el texto y solo hace la
+ * llamada escribir al vaciar el buffer: segun el modo, en cada fin de
+ * linea o al llenarse, y siempre con vaciar y al terminar. El buffer se
+ * registra en el kernel para que lo vacie si el proceso muere sin pasar
+ * por terminar_proceso. Los hilos de un proceso lo comparten.
+ *
+ */
+
+static char buf_salida[TAM_BUF_SALIDA];
+static int lon_salida = 0;
+static int modo_salida = BUF_LINEA;
+static int salida_registrada = 0;
+static cerrojo cerrojo_salida = CERROJO_INICIAL;
+
+static void vaciar_salida() {
+    if (lon_salida > 0) {
+        escribir(buf_salida, lon_salida);
+        lon_salida = 0;
+    }
+}
+
+static void meter_salida(const char *texto, int longi) {
+    int i, fin_linea = 0;
+
+    if (!salida_registrada) {
+        llamsis(BUFFER_SALIDA, 2, (long) buf_salida, (long) &lon_salida);
+        salida_registrada = 1;
+    }
+    if (longi > TAM_BUF_SALIDA - lon_salida)
+        vaciar_salida();
+    if (modo_salida == SIN_BUF || longi >= TAM_BUF_SALIDA) {
+        escribir((char *) texto, longi);
+        return;
+    }
+    for (i = 0; i < longi; i++) {
+        buf_salida[lon_salida + i] = texto[i];
+        fin_linea |= (texto[i] == '\n');
+    }
+    lon_salida += longi;
+    if ((fin_linea && modo_salida == BUF_LINEA) || lon_salida == TAM_BUF_SALIDA)
+        vaciar_salida();
+}
+
+int escribirf_buf(const char *formato, ...) {
+    char texto[TAM_BUF_SALIDA];
+    va_list args;
+    int n;
+
+    va_start(args, formato);
+    n = vsnprintf(texto, sizeof(texto), formato, args);
+    va_end(args);
+    if (n <= 0)
+        return n;
+    if (n >= (int) sizeof(texto))
+        n = sizeof(texto) - 1; /* texto truncado */
+
+    echar_cerrojo(&cerrojo_salida);
+    meter_salida(texto, n);
+    quitar_cerrojo(&cerrojo_salida);
+    return n;
+}
+
+int modo_buffer(int modo) {
+    int anterior = modo_salida;
+
+    if (modo != BUF_LINEA && modo != BUF_COMPLETO && modo != SIN_BUF)
+        return -1;
+    echar_cerrojo(&cerrojo_salida);
+    vaciar_salida();
+    modo_salida = modo;
+    quitar_cerrojo(&cerrojo_salida);
+    return anterior;
+}
+
+int vaciar() {
+    echar_cerrojo(&cerrojo_salida);
+    vaciar_salida();
+    quitar_cerrojo(&cerrojo_salida);
+    return 0;
+}
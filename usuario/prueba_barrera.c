@@ -0,0 +1,96 @@
+/*
+ * usuario/prueba_barrera.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba las barreras y las cuentas atras. Los
+ * hilos recorren varias fases con cargas distintas separadas por una
+ * barrera; al pasarla, todos deben haber terminado la fase anterior.
+ * El hilo principal espera en una cuenta atras a que acaben todos.
+ * Despues comprueba que un participante que termina deja de contarse y
+ * libera al que le esperaba.
+ */
+
+#include "servicios.h"
+
+#define NUM_HILOS 3
+#define NUM_FASES 3
+#define CARGA 2000000
+
+static int completados[NUM_FASES];
+static int ultimos = 0;
+
+static int trabajador(void *arg) {
+	int n = (int) (long) arg;
+	int b = abrir_barrera("barrera");
+	int c = abrir_cuenta("cuenta");
+	int f, i, j;
+
+	for (f = 0; f < NUM_FASES; f++) {
+		for (i = 0; i < n + 1; i++)
+			for (j = 0; j < CARGA; j++);
+		completados[f]++;
+		if (barrera_esperar(b) == 1)
+			ultimos++;
+		if (completados[f] != NUM_HILOS)
+			printf("trabajador %d pasa la fase %d antes que el resto. NO DEBE APARECER\n", n, f);
+	}
+	printf("trabajador %d termina\n", n);
+	cuenta_descontar(c);
+	cerrar_barrera(b);
+	cerrar_cuenta(c);
+	return 0;
+}
+
+/* pasa una fase con el hilo principal y termina sin cerrar la barrera */
+static int desertor(void *arg) {
+	int b = abrir_barrera("bsale");
+
+	barrera_esperar(b);
+	dormir(1);
+	return 0;
+}
+
+int main(){
+	int b, c, i;
+
+	printf("prueba_barrera: comienza\n");
+
+	if (crear_barrera("bnula", 0) >= 0)
+		printf("barrera sin participantes. NO DEBE APARECER\n");
+	b = crear_barrera("barrera", NUM_HILOS);
+	c = crear_cuenta("cuenta", NUM_HILOS);
+	if (b < 0 || c < 0)
+		printf("error creando barrera o cuenta. NO DEBE APARECER\n");
+
+	for (i = 0; i < NUM_HILOS; i++)
+		crear_hilo(trabajador, (void *) (long) i);
+
+	cuenta_esperar(c);
+	printf("cuenta a cero: fases completadas %d %d %d. DEBE SER %d %d %d\n",
+		completados[0], completados[1], completados[2],
+		NUM_HILOS, NUM_HILOS, NUM_HILOS);
+	printf("ultimos en llegar: %d. DEBE SER %d\n", ultimos, NUM_FASES);
+
+	/* una cuenta a cero no bloquea */
+	cuenta_descontar(c);
+	cuenta_esperar(c);
+
+	cerrar_barrera(b);
+	cerrar_cuenta(c);
+
+	b = crear_barrera("bsale", 2);
+	i = crear_hilo(desertor, 0);
+	barrera_esperar(b);
+	barrera_esperar(b);	/* hasta que termina el desertor */
+	printf("barrera abandonada superada\n");
+	barrera_esperar(b);	/* ya es el unico participante */
+	esperar_hilo(i);
+	cerrar_barrera(b);
+
+	printf("prueba_barrera: termina\n");
+	return 0;
+}
@@ -0,0 +1,39 @@
+/*
+ * usuario/prueba_buffer.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba la salida con buffer de la biblioteca,
+ * que solo usa quien llama a escribirf_buf.
+ * En modo completo el texto no sale hasta vaciar el buffer, de modo que
+ * una escritura directa posterior aparece antes. Al final causa una
+ * excepcion con texto pendiente, que debe escribir el kernel.
+ */
+
+#include "servicios.h"
+
+int main(){
+	int i, cero = 0;
+
+	escribirf_buf("prueba_buffer: comienza\n");
+
+	if (modo_buffer(BUF_COMPLETO) != BUF_LINEA)
+		escribirf_buf("modo inicial incorrecto. NO DEBE APARECER\n");
+	escribirf_buf("prueba_buffer: linea 1 con buffer\n");
+	escribirf_buf("prueba_buffer: linea 2 con buffer\n");
+	escribir("prueba_buffer: escritura directa, DEBE SALIR ANTES QUE LAS LINEAS 1 Y 2\n", 72);
+	vaciar();
+
+	/* 1000 lineas en unas pocas llamadas escribir */
+	for (i = 0; i < 1000; i++)
+		escribirf_buf("%d%c", i % 10, i % 50 == 49 ? '\n' : ' ');
+
+	escribirf_buf("prueba_buffer: pendiente al morir, DEBE SALIR\n");
+	i /= cero;
+
+	escribirf_buf("prueba_buffer: NO DEBE APARECER\n");
+	return 0;
+}
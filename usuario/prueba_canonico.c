@@ -0,0 +1,49 @@
+/*
+ * usuario/prueba_canonico.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba el modo canonico del terminal. Lee dos
+ * lineas: en la primera se borra un caracter y en la segunda se borra
+ * toda la linea con control-U antes de escribirla de nuevo. Despues
+ * vuelve al modo crudo y lee un caracter suelto.
+ */
+
+#include "servicios.h"
+
+static void mostrar(char *buf, int n) {
+	int i;
+
+	printf("prueba_canonico: linea de %d: ", n);
+	for (i = 0; i < n; i++)
+		printf("%c", buf[i] == '\n' ? '$' : buf[i]);
+	printf("\n");
+}
+
+int main(){
+	char buf[32];
+	int n;
+
+	printf("prueba_canonico: comienza\n");
+	if (modo_terminal(MODO_CANONICO) != MODO_CRUDO)
+		printf("modo anterior incorrecto. NO DEBE APARECER\n");
+
+	printf("prueba_canonico: escribe una linea\n");
+	n = leer(buf, sizeof(buf), 1);
+	mostrar(buf, n);
+
+	printf("prueba_canonico: escribe otra linea\n");
+	n = leer(buf, sizeof(buf), 1);
+	mostrar(buf, n);
+
+	if (modo_terminal(MODO_CRUDO) != MODO_CANONICO)
+		printf("modo anterior incorrecto. NO DEBE APARECER\n");
+	printf("prueba_canonico: pulsa un caracter\n");
+	printf("prueba_canonico: has pulsado %c\n", leer_caracter());
+
+	printf("prueba_canonico: termina\n");
+	return 0;
+}
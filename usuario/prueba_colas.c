@@ -0,0 +1,120 @@
+/*
+ * usuario/prueba_colas.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba las colas de mensajes. Comprueba el
+ * orden de entrega por prioridad, los plazos de enviar y recibir, la
+ * recepcion por lotes, que un emisor se bloquea con la cola llena hasta
+ * que un hilo receptor saca mensajes y que un emisor que muere al copiar
+ * el mensaje no deja la cola con menos huecos.
+ */
+
+#include <string.h>
+#include "servicios.h"
+
+#define MAX_MENSAJES 4
+#define TAM_MENSAJE 32
+#define ENVIOS_HILO 6
+
+static int receptor(void *arg) {
+	int c = abrir_cola("cprueba");
+	char buf[TAM_MENSAJE];
+	int i, lon;
+
+	dormir(1);	/* deja que el emisor llene la cola */
+	for (i = 0; i < ENVIOS_HILO; i++) {
+		lon = recibir(c, buf, sizeof(buf), NULL, -1);
+		printf("receptor: recibido %.*s\n", lon, buf);
+	}
+	cerrar_cola(c);
+	return 0;
+}
+
+static int emisor_erroneo(void *arg) {
+	int c = abrir_cola("cprueba");
+
+	enviar(c, (char *) 1, TAM_MENSAJE, 0, -1);	/* termina aqui */
+	printf("envio desde una direccion erronea. NO DEBE APARECER\n");
+	return 0;
+}
+
+int main(){
+	char *textos[] = {"uno", "cinco", "dos", "siete"};
+	int prios[] = {1, 5, 1, 7};
+	char *orden[] = {"siete", "cinco", "uno", "dos"};
+	struct mensaje lote[8];
+	char bufs[8][TAM_MENSAJE], buf[TAM_MENSAJE];
+	int c, h, i, lon, prio, n;
+
+	printf("prueba_colas: comienza\n");
+
+	c = crear_cola("cprueba", MAX_MENSAJES, TAM_MENSAJE);
+	if (c < 0)
+		printf("error creando la cola. NO DEBE APARECER\n");
+	if (crear_cola("cprueba", 1, 1) >= 0)
+		printf("cola con nombre repetido. NO DEBE APARECER\n");
+	if (enviar(c, buf, TAM_MENSAJE + 1, 0, 0) != -1)
+		printf("mensaje demasiado grande. NO DEBE APARECER\n");
+
+	/* se entregan por prioridad y con la misma por orden de llegada */
+	for (i = 0; i < MAX_MENSAJES; i++)
+		enviar(c, textos[i], strlen(textos[i]), prios[i], -1);
+	if (enviar(c, "otro", 4, 0, 0) != -1)
+		printf("envio con la cola llena. NO DEBE APARECER\n");
+	if (enviar(c, "otro", 4, 0, 200) != -1)
+		printf("envio con plazo y la cola llena. NO DEBE APARECER\n");
+	if (recibir(c, buf, 2, &prio, 0) != -1)
+		printf("mensaje que no cabe. NO DEBE APARECER\n");
+	for (i = 0; i < MAX_MENSAJES; i++) {
+		lon = recibir(c, buf, sizeof(buf), &prio, -1);
+		if (lon != strlen(orden[i]) || strncmp(buf, orden[i], lon) != 0)
+			printf("orden de entrega erroneo. NO DEBE APARECER\n");
+		else
+			printf("prueba_colas: recibido %.*s con prioridad %d\n", lon, buf, prio);
+	}
+	if (recibir(c, buf, sizeof(buf), &prio, 300) != -1)
+		printf("recepcion con la cola vacia. NO DEBE APARECER\n");
+
+	/* recepcion de varios mensajes en una sola llamada */
+	enviar(c, "a", 1, 0, -1);
+	enviar(c, "bb", 2, 3, -1);
+	enviar(c, "ccc", 3, 0, -1);
+	for (i = 0; i < 8; i++) {
+		lote[i].buf = bufs[i];
+		lote[i].tam = TAM_MENSAJE;
+	}
+	n = recibir_lote(c, lote, 8, 0);
+	printf("prueba_colas: lote de %d mensajes:", n);
+	for (i = 0; i < n; i++)
+		printf(" %.*s(%d)", lote[i].lon, lote[i].buf, lote[i].prioridad);
+	printf("\n");
+
+	/* el emisor se bloquea con la cola llena hasta que el hilo recibe */
+	h = crear_hilo(receptor, 0);
+	for (i = 0; i < ENVIOS_HILO; i++) {
+		buf[0] = 'A' + i;
+		enviar(c, buf, 1, 0, -1);
+		printf("prueba_colas: enviado %c\n", buf[0]);
+	}
+	esperar_hilo(h);
+
+	/* el hueco del mensaje que no se pudo copiar sigue libre */
+	h = crear_hilo(emisor_erroneo, 0);
+	esperar_hilo(h);
+	for (i = 0; i < MAX_MENSAJES; i++)
+		if (enviar(c, "y", 1, 0, 0) != 0)
+			printf("hueco perdido. NO DEBE APARECER\n");
+	for (i = 0; i < MAX_MENSAJES; i++)
+		recibir(c, buf, sizeof(buf), NULL, 0);
+
+	cerrar_cola(c);
+	if (enviar(c, "x", 1, 0, 0) != -1)
+		printf("envio a una cola cerrada. NO DEBE APARECER\n");
+
+	printf("prueba_colas: termina\n");
+	return 0;
+}
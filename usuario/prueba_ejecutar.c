@@ -0,0 +1,34 @@
+/*
+ * usuario/prueba_ejecutar.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de la llamada ejecutar.
+ * Crea un mutex y sustituye su imagen por la del programa ejecutado,
+ * que debe conservar el id y el descriptor del mutex.
+ */
+
+#include "servicios.h"
+
+int main(){
+	int desc;
+
+	printf("prueba_ejecutar (%d): comienza\n", obtener_id_pr());
+
+	if ((desc = crear_mutex("mej", NO_RECURSIVO)) < 0)
+		printf("error creando mej. NO DEBE APARECER\n");
+
+	if (ejecutar("noexiste") >= 0)
+		printf("error ejecutando noexiste. NO DEBE APARECER\n");
+
+	printf("prueba_ejecutar (%d): ejecuta el programa ejecutado con el descriptor %d\n",
+		obtener_id_pr(), desc);
+
+	ejecutar("ejecutado");
+
+	printf("prueba_ejecutar: NO DEBE APARECER\n");
+	return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * usuario/prueba_escribirv.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba escribirv. Dos hilos escriben registros
+ * de tres fragmentos a la vez; cada linea debe salir entera, sin mezclar
+ * fragmentos de los dos hilos. Tambien comprueba que se rechazan sin
+ * escribir nada las llamadas con demasiados fragmentos o bytes.
+ */
+
+#include "servicios.h"
+
+#define NUM_REGISTROS 200
+
+static int escritor(void *arg) {
+	struct fragmento reg[3];
+	int i, n;
+
+	reg[0].texto = (char *) arg;
+	reg[0].longi = 14;
+	reg[1].texto = ": fragmento ";
+	reg[1].longi = 12;
+	reg[2].texto = "intacto\n";
+	reg[2].longi = 8;
+	for (i = 0; i < NUM_REGISTROS; i++)
+		if ((n = escribirv(reg, 3)) != 34)
+			printf("escribirv devuelve %d. NO DEBE APARECER\n", n);
+	return 0;
+}
+
+int main(){
+	struct fragmento reg[MAX_FRAGMENTOS + 1];
+	int h;
+
+	printf("prueba_escribirv: comienza\n");
+	h = crear_hilo(escritor, "escritor hilo ");
+	escritor("escritor princ");
+	esperar_hilo(h);
+	if (escribirv(0, 1) != -1)
+		printf("escribirv sin fragmentos. NO DEBE APARECER\n");
+	if (escribirv(reg, MAX_FRAGMENTOS + 1) != -1)
+		printf("escribirv con demasiados fragmentos. NO DEBE APARECER\n");
+	reg[0].texto = "x";
+	reg[0].longi = 1;
+	reg[1].texto = "y";
+	reg[1].longi = (unsigned int) -1;
+	if (escribirv(reg, 2) != -1)
+		printf("escribirv con longitud negativa. NO DEBE APARECER\n");
+	if (escribir("x", MAX_ESCRITURA + 1) != -1)
+		printf("escribir demasiado largo. NO DEBE APARECER\n");
+	printf("prueba_escribirv: termina\n");
+	return 0;
+}
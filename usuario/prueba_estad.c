@@ -0,0 +1,64 @@
+/*
+ * usuario/prueba_estad.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba las estadisticas de los mutex. Un hilo
+ * se bloquea en un mutex que el hilo principal retiene un segundo, y
+ * despues se consultan los contadores con estadisticas_mutex.
+ */
+
+#include "servicios.h"
+
+static int competidor(void *arg) {
+	int m = abrir_mutex("mestad");
+
+	lock(m);
+	unlock(m);
+	cerrar_mutex(m);
+	return 0;
+}
+
+static void mostrar(struct estad_mutex *e) {
+	printf("%s: %d locks, %d con espera, %d desistidos, espera %d (max %d), "
+		"retencion %d (max %d), propietario %d, esperando %d\n",
+		e->nombre, e->adquisiciones, e->con_espera, e->desistidos,
+		e->espera_total, e->espera_max, e->retencion_total,
+		e->retencion_max, e->propietario, e->esperando);
+}
+
+int main(){
+	struct estad_mutex tabla[4];
+	int m, h, n;
+
+	printf("prueba_estad: comienza\n");
+
+	m = crear_mutex("mestad", NO_RECURSIVO);
+	lock(m);
+	h = crear_hilo(competidor, 0);
+	dormir(1);
+
+	n = estadisticas_mutex(tabla, 4);
+	if (n != 1)
+		printf("estadisticas de %d mutex. NO DEBE APARECER\n", n);
+	mostrar(&tabla[0]);
+	printf("DEBE SER 1 lock, propietario %d y 1 esperando\n", obtener_id_pr());
+
+	unlock(m);
+	esperar_hilo(h);
+	if (trylock(m) != 0 || unlock(m) != 0)
+		printf("error en trylock. NO DEBE APARECER\n");
+
+	estadisticas_mutex(tabla, 4);
+	mostrar(&tabla[0]);
+	printf("DEBE SER 3 locks, 1 con espera de unos 100 ticks, retencion max unos 100\n");
+
+	cerrar_mutex(m);
+	if (estadisticas_mutex(tabla, 4) != 0)
+		printf("estadisticas de mutex cerrado. NO DEBE APARECER\n");
+	printf("prueba_estad: termina\n");
+	return 0;
+}
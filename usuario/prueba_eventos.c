@@ -0,0 +1,65 @@
+/*
+ * usuario/prueba_eventos.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba esperar_eventos y las lecturas no
+ * bloqueantes. Espera a la vez al terminal y a un mutex que un hilo
+ * retiene un segundo, despues comprueba que vence el plazo y por ultimo
+ * espera a que se pulse un caracter.
+ */
+
+#include "servicios.h"
+
+static int retenedor(void *arg) {
+	int m = abrir_mutex("meventos");
+
+	lock(m);
+	dormir(1);
+	unlock(m);
+	cerrar_mutex(m);
+	return 0;
+}
+
+int main(){
+	struct evento ev[2];
+	int m, h, n, car;
+
+	printf("prueba_eventos: comienza\n");
+
+	m = crear_mutex("meventos", NO_RECURSIVO);
+	h = crear_hilo(retenedor, 0);
+	while (trylock(m) == 0)	/* hasta que el hilo lo cierre */
+		unlock(m);
+
+	ev[0].tipo = EV_TERMINAL;
+	ev[1].tipo = EV_MUTEX;
+	ev[1].id = m;
+	n = esperar_eventos(ev, 2, -1);
+	printf("prueba_eventos: %d listos, terminal %d, mutex %d\n",
+		n, ev[0].listo, ev[1].listo);
+	printf("DEBE ESTAR LISTO SOLO EL MUTEX\n");
+	esperar_hilo(h);
+
+	lock(m);
+	if (esperar_eventos(&ev[1], 1, 500) != 0)
+		printf("no vence el plazo. NO DEBE APARECER\n");
+	if (esperar_eventos(&ev[1], 1, 0) != 0)
+		printf("mutex cerrado listo. NO DEBE APARECER\n");
+	unlock(m);
+
+	no_bloqueante(1);
+	if (leer_caracter() != -1)
+		printf("lectura no bloqueante con datos. NO DEBE APARECER\n");
+	printf("prueba_eventos: pulsa un caracter\n");
+	n = esperar_eventos(ev, 1, -1);
+	car = leer_caracter();
+	printf("prueba_eventos: %d listos, has pulsado %c\n", n, car);
+
+	cerrar_mutex(m);
+	printf("prueba_eventos: termina\n");
+	return 0;
+}
@@ -0,0 +1,163 @@
+/*
+ * usuario/prueba_ficheros.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba los ficheros del anfitrion y la cache
+ * de paginas. Escribe un fichero de PAGINAS paginas y comprueba que al
+ * volver a abrirlo sigue en la cache. Despues lo saca de ella escribiendo
+ * otro mas grande y lo recorre con lecturas pequenas, que deben costar
+ * una lectura del anfitrion por cada PAGINAS_ANT paginas; una segunda
+ * pasada no debe leer nada. Por ultimo prueba posicionar, los huecos, el
+ * volcado periodico, los errores y que se pueden abrir mas ficheros de
+ * los que caben a la vez en la tabla de inodos si se van cerrando.
+ */
+
+#include "servicios.h"
+
+#define TAM_PAGINA 4096
+#define PAGINAS 8
+#define TAM_FICH (PAGINAS * TAM_PAGINA)
+#define PAGINAS_CACHE 64
+#define NUM_FICHEROS 20
+
+static struct estad_cache antes;
+
+static void medir() {
+	estad_cache(&antes);
+}
+
+static void mostrar(char *fase) {
+	struct estad_cache e;
+
+	estad_cache(&e);
+	printf("prueba_ficheros: %s: %u aciertos, %u fallos, %u anticipadas, "
+	       "%u lecturas, %u escrituras\n", fase, e.aciertos - antes.aciertos,
+	       e.fallos - antes.fallos, e.anticipadas - antes.anticipadas,
+	       e.lecturas - antes.lecturas, e.escrituras - antes.escrituras);
+}
+
+/* crea el fichero nombre con tam bytes y lo cierra */
+static void llenar(char *nombre, int tam) {
+	char buf[1000];
+	int fd, i, escritos = 0;
+
+	fd = abrir_fichero(nombre, FICH_ESCRITURA | FICH_CREAR | FICH_TRUNCAR);
+	while (escritos < tam) {
+		int n = tam - escritos < sizeof(buf) ? tam - escritos : sizeof(buf);
+
+		for (i = 0; i < n; i++)
+			buf[i] = 'a' + (escritos + i) % 26;
+		escritos += escribir_fd(fd, buf, n);
+	}
+	if (leer_fd(fd, buf, 1) != -1)
+		printf("lectura en modo escritura. NO DEBE APARECER\n");
+	medir();
+	if (cerrar_fd(fd) < 0)
+		printf("error al cerrar %s. NO DEBE APARECER\n", nombre);
+}
+
+/* lee el fichero entero en trozos de 100 bytes comprobando el contenido */
+static void recorrer(int fd) {
+	char buf[100];
+	int n, i, total = 0;
+
+	posicionar(fd, 0, POS_INICIO);
+	while ((n = leer_fd(fd, buf, sizeof(buf))) > 0) {
+		for (i = 0; i < n; i++)
+			if (buf[i] != 'a' + (total + i) % 26) {
+				printf("contenido erroneo. NO DEBE APARECER\n");
+				return;
+			}
+		total += n;
+	}
+	if (total != TAM_FICH)
+		printf("tamano leido erroneo. NO DEBE APARECER\n");
+}
+
+int main(){
+	struct estad_cache e;
+	char buf[1000], nombre[8];
+	int fd, i;
+
+	printf("prueba_ficheros: comienza\n");
+
+	if (abrir_fichero("../fuera", FICH_LECTURA | FICH_CREAR) >= 0)
+		printf("nombre fuera del directorio. NO DEBE APARECER\n");
+	if (abrir_fichero("noexiste", FICH_LECTURA) >= 0)
+		printf("fichero inexistente. NO DEBE APARECER\n");
+
+	llenar("datos", TAM_FICH);
+	mostrar("al cerrar");
+
+	/* cerrado sigue en la cache */
+	fd = abrir_fichero("datos", FICH_LECTURA);
+	medir();
+	recorrer(fd);
+	mostrar("tras reabrir");
+	estad_cache(&e);
+	if (e.lecturas != antes.lecturas)
+		printf("fichero cerrado fuera de la cache. NO DEBE APARECER\n");
+	cerrar_fd(fd);
+
+	/* recorrido secuencial con el fichero fuera de la cache */
+	llenar("relleno", PAGINAS_CACHE * TAM_PAGINA);
+	fd = abrir_fichero("datos", FICH_LECTURA);
+	if (posicionar(fd, 0, POS_FINAL) != TAM_FICH)
+		printf("tamano erroneo. NO DEBE APARECER\n");
+	medir();
+	recorrer(fd);
+	mostrar("primera pasada");
+	medir();
+	recorrer(fd);
+	mostrar("segunda pasada");
+	if (escribir_fd(fd, buf, 1) != -1)
+		printf("escritura en modo lectura. NO DEBE APARECER\n");
+
+	/* abierto solo para leer, se puede abrir despues para escribir */
+	i = abrir_fichero("datos", FICH_ESCRITURA);
+	cerrar_fd(fd);
+	if (i < 0 || escribir_fd(i, "a", 1) != 1 || cerrar_fd(i) < 0)
+		printf("error escribiendo un fichero abierto para leer. NO DEBE APARECER\n");
+
+	/* una lectura suelta no lee por adelantado */
+	llenar("relleno", PAGINAS_CACHE * TAM_PAGINA);
+	fd = abrir_fichero("datos", FICH_LECTURA | FICH_ESCRITURA);
+	medir();
+	posicionar(fd, 3 * TAM_PAGINA, POS_INICIO);
+	leer_fd(fd, buf, 10);
+	mostrar("lectura suelta");
+
+	/* escribir detras del final deja un hueco de ceros */
+	posicionar(fd, 10, POS_FINAL);
+	escribir_fd(fd, "fin", 3);
+	posicionar(fd, TAM_FICH, POS_INICIO);
+	if (leer_fd(fd, buf, sizeof(buf)) != 13 || buf[0] != 0 || buf[9] != 0
+	    || buf[10] != 'f')
+		printf("hueco erroneo. NO DEBE APARECER\n");
+
+	/* las paginas sucias se escriben solas aunque no se cierre */
+	medir();
+	dormir(2);
+	mostrar("tras dormir");
+	cerrar_fd(fd);
+
+	/* los inodos de ficheros cerrados se reutilizan */
+	for (i = 0; i < NUM_FICHEROS; i++) {
+		nombre[0] = 'f';
+		nombre[1] = '0' + i / 10;
+		nombre[2] = '0' + i % 10;
+		nombre[3] = '\0';
+		llenar(nombre, 10);
+	}
+	fd = abrir_fichero("datos", FICH_LECTURA);
+	if (fd < 0 || posicionar(fd, 0, POS_FINAL) != TAM_FICH + 13)
+		printf("error reabriendo datos. NO DEBE APARECER\n");
+	cerrar_fd(fd);
+
+	printf("prueba_ficheros: termina\n");
+	return 0;
+}
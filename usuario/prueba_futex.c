@@ -0,0 +1,64 @@
+/*
+ * usuario/prueba_futex.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba el cerrojo de biblioteca construido
+ * sobre futex_esperar y futex_despertar. Varios hilos incrementan un
+ * contador compartido dentro de una seccion critica lo bastante larga
+ * para que la rodaja expire con el cerrojo echado.
+ */
+
+#include "servicios.h"
+
+#define NUM_HILOS 3
+#define NUM_ITER 100
+#define TOT_ITER 2000000
+
+static cerrojo c = CERROJO_INICIAL;
+static volatile int contador = 0;
+
+static int incrementador(void *arg) {
+	int n = (int) (long) arg;
+	int i, j, valor;
+
+	printf("incrementador %d (%d): comienza\n", n, obtener_id_pr());
+	for (i = 0; i < NUM_ITER; i++) {
+		echar_cerrojo(&c);
+		valor = contador;
+		for (j = 0; j < TOT_ITER; j++);
+		contador = valor + 1;
+		quitar_cerrojo(&c);
+	}
+	printf("incrementador %d (%d): termina\n", n, obtener_id_pr());
+	return 0;
+}
+
+int main(){
+	int hilos[NUM_HILOS];
+	int i, palabra = 1;
+
+	printf("prueba_futex: comienza\n");
+
+	if (futex_esperar(&palabra, 0) >= 0)
+		printf("futex_esperar con valor distinto se bloquea. NO DEBE APARECER\n");
+	if (futex_despertar(&palabra, 1) != 0)
+		printf("futex_despertar sin esperas despierta. NO DEBE APARECER\n");
+
+	for (i = 0; i < NUM_HILOS; i++)
+		if ((hilos[i] = crear_hilo(incrementador, (void *) (long) i)) < 0)
+			printf("error creando hilo %d. NO DEBE APARECER\n", i);
+
+	for (i = 0; i < NUM_HILOS; i++)
+		esperar_hilo(hilos[i]);
+
+	if (contador != NUM_HILOS * NUM_ITER)
+		printf("contador %d incorrecto. NO DEBE APARECER\n", contador);
+	printf("contador final: %d. DEBE SER %d\n", contador, NUM_HILOS * NUM_ITER);
+
+	printf("prueba_futex: termina\n");
+	return 0;
+}
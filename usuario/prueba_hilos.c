@@ -0,0 +1,97 @@
+/*
+ * usuario/prueba_hilos.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de las llamadas crear_hilo,
+ * terminar_hilo y esperar_hilo. Los hilos reparten una suma sobre un
+ * vector global que comparten con el hilo principal. Tambien comparten
+ * los descriptores de fichero: los de una tuberia que crea un hilo
+ * siguen abiertos cuando termina. Los de mutex, en cambio, son de cada
+ * hilo: un hilo no puede usar los de su creador y abre el mutex por
+ * nombre.
+ */
+
+#include "servicios.h"
+
+#define NUM_HILOS 3
+#define TAM_VECTOR 3000
+
+static int vector[TAM_VECTOR];
+static int parciales[NUM_HILOS];
+static int tub[2];
+static int mutex_creador;
+
+static int sumador(void *arg) {
+	int n = (int) (long) arg;
+	int i, suma = 0;
+
+	printf("sumador %d (%d): comienza\n", n, obtener_id_pr());
+	for (i = n; i < TAM_VECTOR; i += NUM_HILOS)
+		suma += vector[i];
+	parciales[n] = suma;
+
+	printf("sumador %d (%d): termina\n", n, obtener_id_pr());
+	return n + 10;
+}
+
+static int usuario_mutex(void *arg) {
+	int m;
+
+	if (lock(mutex_creador) != -1)
+		printf("hilo con el descriptor del creador. NO DEBE APARECER\n");
+	if ((m = abrir_mutex("mhilos")) < 0 || lock(m) < 0 || unlock(m) < 0
+	    || cerrar_mutex(m) < 0)
+		printf("error usando el mutex por nombre. NO DEBE APARECER\n");
+	return 0;
+}
+
+static int tubero(void *arg) {
+	if (crear_tuberia(tub) < 0 || escribir_fd(tub[1], "hola", 4) != 4)
+		printf("error en la tuberia del hilo. NO DEBE APARECER\n");
+	return 0;
+}
+
+int main(){
+	int hilos[NUM_HILOS];
+	int i, hilo, total = 0;
+	char buf[8];
+
+	printf("prueba_hilos: comienza\n");
+
+	for (i = 0; i < TAM_VECTOR; i++)
+		vector[i] = i;
+
+	for (i = 0; i < NUM_HILOS; i++)
+		if ((hilos[i] = crear_hilo(sumador, (void *) (long) i)) < 0)
+			printf("error creando hilo %d. NO DEBE APARECER\n", i);
+
+	if (esperar_hilo(obtener_id_pr()) >= 0)
+		printf("error esperandose a si mismo. NO DEBE APARECER\n");
+
+	for (i = 0; i < NUM_HILOS; i++)
+		if (esperar_hilo(hilos[i]) != i + 10)
+			printf("error esperando hilo %d. NO DEBE APARECER\n", i);
+
+	for (i = 0; i < NUM_HILOS; i++)
+		total += parciales[i];
+	printf("prueba_hilos: suma %d (debe ser %d)\n", total,
+		TAM_VECTOR * (TAM_VECTOR - 1) / 2);
+
+	mutex_creador = crear_mutex("mhilos", NO_RECURSIVO);
+	if ((hilo = crear_hilo(usuario_mutex, 0)) < 0 || esperar_hilo(hilo) != 0)
+		printf("error con el hilo del mutex. NO DEBE APARECER\n");
+	cerrar_mutex(mutex_creador);
+
+	if ((hilo = crear_hilo(tubero, 0)) < 0 || esperar_hilo(hilo) != 0)
+		printf("error con el hilo de la tuberia. NO DEBE APARECER\n");
+	if (leer_fd(tub[0], buf, sizeof(buf)) != 4 || cerrar_fd(tub[1]) < 0
+	    || cerrar_fd(tub[0]) < 0)
+		printf("tuberia del hilo cerrada. NO DEBE APARECER\n");
+
+	printf("prueba_hilos: termina\n");
+	return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * usuario/prueba_lectesc.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba los cerrojos de lectura/escritura con
+ * sus dos politicas. Con el cerrojo cerrado para escritura se bloquean
+ * varios lectores y despues un escritor; al liberarlo se anota el orden
+ * en que entran y cuantos lectores llegan a estar dentro a la vez.
+ */
+
+#include "servicios.h"
+
+#define NUM_LECTORES 3
+
+static char orden[NUM_LECTORES + 2];
+static int num_orden;
+static int dentro;
+static int max_dentro;
+
+static int lector(void *arg) {
+	int c = abrir_lectesc("lectesc");
+
+	lock_lectura(c);
+	orden[num_orden++] = 'L';
+	if (++dentro > max_dentro)
+		max_dentro = dentro;
+	dormir(1);
+	dentro--;
+	unlock_lectesc(c);
+	cerrar_lectesc(c);
+	return 0;
+}
+
+static int escritor(void *arg) {
+	int c = abrir_lectesc("lectesc");
+
+	lock_escritura(c);
+	orden[num_orden++] = 'E';
+	if (dentro != 0)
+		printf("escritor con lectores dentro. NO DEBE APARECER\n");
+	unlock_lectesc(c);
+	cerrar_lectesc(c);
+	return 0;
+}
+
+static void probar(int politica, char *esperado) {
+	int hilos[NUM_LECTORES + 1];
+	int c, i;
+
+	num_orden = dentro = max_dentro = 0;
+	if ((c = crear_lectesc("lectesc", politica)) < 0)
+		printf("error creando cerrojo. NO DEBE APARECER\n");
+	lock_escritura(c);
+	if (lock_lectura(c) >= 0)
+		printf("lock de lectura con el de escritura. NO DEBE APARECER\n");
+
+	for (i = 0; i < NUM_LECTORES; i++)
+		hilos[i] = crear_hilo(lector, 0);
+	dormir(1);
+	hilos[NUM_LECTORES] = crear_hilo(escritor, 0);
+	dormir(1);
+
+	/* todos bloqueados: al liberar se aplica la politica */
+	unlock_lectesc(c);
+	for (i = 0; i <= NUM_LECTORES; i++)
+		esperar_hilo(hilos[i]);
+	orden[num_orden] = '\0';
+
+	printf("politica %d: orden %s. DEBE SER %s\n", politica, orden, esperado);
+	printf("politica %d: maximo de lectores a la vez %d. DEBE SER %d\n",
+		politica, max_dentro, NUM_LECTORES);
+	cerrar_lectesc(c);
+}
+
+int main(){
+	printf("prueba_lectesc: comienza\n");
+
+	if (crear_lectesc("lectesc", 7) >= 0)
+		printf("politica desconocida. NO DEBE APARECER\n");
+
+	probar(LECTESC_PREF_ESCRITOR, "ELLL");
+	probar(LECTESC_EQUITATIVO, "LLLE");
+
+	printf("prueba_lectesc: termina\n");
+	return 0;
+}
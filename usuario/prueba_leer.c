@@ -0,0 +1,51 @@
+/*
+ * usuario/prueba_leer.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba la lectura de bloques del terminal.
+ * Pide al menos 4 caracteres de una vez, duerme para que se acumulen
+ * varios y los recoge con una sola llamada, y por ultimo comprueba que
+ * con min igual a 0 no se bloquea.
+ */
+
+#include "servicios.h"
+
+static void mostrar(char *buf, int n) {
+	int i;
+
+	printf("prueba_leer: leidos %d: ", n);
+	for (i = 0; i < n; i++)
+		printf("%c", buf[i]);
+	printf("\n");
+}
+
+int main(){
+	char buf[16];
+	int n;
+
+	printf("prueba_leer: comienza\n");
+	printf("prueba_leer: pulsa al menos 4 caracteres\n");
+	n = leer(buf, sizeof(buf), 4);
+	mostrar(buf, n);
+	if (n < 4)
+		printf("menos de 4 caracteres. NO DEBE APARECER\n");
+
+	printf("prueba_leer: duerme 3 segundos, sigue pulsando\n");
+	dormir(3);
+	n = leer(buf, 5, 1);
+	mostrar(buf, n);
+	printf("DEBE HABER LEIDO 5 CARACTERES DE UNA VEZ\n");
+
+	n = leer(buf, sizeof(buf), 0);
+	mostrar(buf, n);
+
+	if (leer(buf, -1, 0) >= 0)
+		printf("lectura de tamano negativo. NO DEBE APARECER\n");
+
+	printf("prueba_leer: termina\n");
+	return 0;
+}
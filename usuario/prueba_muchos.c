@@ -0,0 +1,85 @@
+/*
+ * usuario/prueba_muchos.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que primero crea y cierra muchos mutex con pocos
+ * vivos a la vez, lo que llena la tabla hash de marcas de borrado, y
+ * despues abre muchos mas mutex que los NUM_MUT_PROC descriptores
+ * iniciales y que los NUM_MUT de la tabla del sistema, para probar que
+ * ambas tablas crecen y que se asigna el descriptor libre mas bajo.
+ */
+
+#include "servicios.h"
+
+#define NUM_MUCHOS 200
+#define NUM_VUELTAS 1000
+#define NUM_VIVOS 14
+
+static void nombre_mutex(char *nombre, int i) {
+	nombre[0] = 'n';
+	nombre[1] = '0' + i / 100;
+	nombre[2] = '0' + (i / 10) % 10;
+	nombre[3] = '0' + i % 10;
+	nombre[4] = '\0';
+}
+
+int main(){
+	char nombre[5];
+	int vivos[NUM_VIVOS];
+	int i, d;
+
+	printf("prueba_muchos: comienza\n");
+
+	/* cada vuelta cierra el mutex de hace NUM_VIVOS vueltas y crea otro */
+	for (i = 0; i < NUM_VUELTAS; i++) {
+		if (i >= NUM_VIVOS) {
+			cerrar_mutex(vivos[i % NUM_VIVOS]);
+			nombre_mutex(nombre, (i - NUM_VIVOS) % 1000);
+			if ((d = abrir_mutex(nombre)) >= 0) {
+				printf("%s sigue abierto. NO DEBE APARECER\n", nombre);
+				cerrar_mutex(d);
+			}
+		}
+		nombre_mutex(nombre, i % 1000);
+		if ((vivos[i % NUM_VIVOS] = crear_mutex(nombre, NO_RECURSIVO)) < 0)
+			printf("crear %s en la vuelta %d. NO DEBE APARECER\n", nombre, i);
+	}
+	for (i = 0; i < NUM_VIVOS; i++)
+		cerrar_mutex(vivos[i]);
+	for (i = NUM_VUELTAS - NUM_VIVOS; i < NUM_VUELTAS; i++) {
+		nombre_mutex(nombre, i % 1000);
+		if ((d = abrir_mutex(nombre)) >= 0) {
+			printf("%s sigue abierto. NO DEBE APARECER\n", nombre);
+			cerrar_mutex(d);
+		}
+	}
+
+	for (i = 0; i < NUM_MUCHOS; i++) {
+		nombre_mutex(nombre, i);
+		if ((d = crear_mutex(nombre, NO_RECURSIVO)) != i)
+			printf("crear %s da descriptor %d. NO DEBE APARECER\n",
+				nombre, d);
+	}
+
+	/* los huecos se reutilizan empezando por el mas bajo */
+	cerrar_mutex(150);
+	cerrar_mutex(7);
+	if ((d = abrir_mutex("n199")) != 7)
+		printf("abrir da descriptor %d y no 7. NO DEBE APARECER\n", d);
+	if ((d = crear_mutex("n150", NO_RECURSIVO)) != 150)
+		printf("crear da descriptor %d y no 150. NO DEBE APARECER\n", d);
+
+	if (lock(199) < 0 || trylock(7) == 0 || unlock(7) < 0)
+		printf("error usando n199 por dos descriptores. NO DEBE APARECER\n");
+
+	for (i = 0; i < NUM_MUCHOS; i++)
+		if (cerrar_mutex(i) < 0)
+			printf("error cerrando %d. NO DEBE APARECER\n", i);
+
+	printf("prueba_muchos: termina\n");
+	return 0;
+}
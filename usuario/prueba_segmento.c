@@ -0,0 +1,87 @@
+/*
+ * usuario/prueba_segmento.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba los segmentos de memoria compartida.
+ * Crea y proyecta un segmento, deja en el un texto y lanza el proceso
+ * compartidor, que lo lee y contesta en la segunda mitad. Comprueba que
+ * las proyecciones son de la imagen y no de cada hilo. Por ultimo
+ * comprueba que el segmento desaparece al cerrarse y desproyectarse en
+ * todos los procesos, incluida la proyeccion que el compartidor no
+ * deshace antes de terminar.
+ */
+
+#include <string.h>
+#include "servicios.h"
+
+#define TAM_SEG 4096
+
+static int proyector(void *arg) {
+	int s = abrir_segmento("sprueba");
+	int tam;
+
+	if (proyectar(s, &tam) == NULL)
+		return -1;
+	return cerrar_segmento(s);
+}
+
+static int desproyector(void *arg) {
+	return desproyectar((char *) arg);
+}
+
+int main(){
+	char *p;
+	int s, m, h, tam, i;
+
+	printf("prueba_segmento: comienza\n");
+
+	if (crear_segmento("sprueba", MAX_TAM_SEG + 1) >= 0)
+		printf("segmento demasiado grande. NO DEBE APARECER\n");
+	s = crear_segmento("sprueba", TAM_SEG);
+	p = proyectar(s, &tam);
+	if (p == NULL || tam != TAM_SEG)
+		printf("error proyectando el segmento. NO DEBE APARECER\n");
+	for (i = 0; i < tam; i++)
+		if (p[i] != 0) {
+			printf("segmento sin iniciar a cero. NO DEBE APARECER\n");
+			break;
+		}
+	strcpy(p, "hola desde prueba_segmento");
+
+	m = crear_sem("ssegm", 0);
+	if (crear_proceso("compartidor") < 0)
+		printf("Error creando compartidor\n");
+	sem_esperar(m);
+	printf("prueba_segmento: el compartidor contesta: %s\n", p + TAM_SEG / 2);
+
+	/* la proyeccion de un hilo sigue al terminar y otro puede deshacerla */
+	h = crear_hilo(proyector, 0);
+	if (esperar_hilo(h) != 0 || desproyectar(p) != 0 || desproyectar(p) != 0)
+		printf("proyeccion del hilo perdida. NO DEBE APARECER\n");
+	h = crear_hilo(desproyector, proyectar(s, &tam));
+	if (esperar_hilo(h) != 0 || desproyectar(p) != -1)
+		printf("el hilo no ve la proyeccion. NO DEBE APARECER\n");
+	p = proyectar(s, &tam);
+
+	/* cerrado pero proyectado sigue siendo accesible */
+	cerrar_segmento(s);
+	if (proyectar(s, NULL) != NULL)
+		printf("proyeccion de descriptor cerrado. NO DEBE APARECER\n");
+	printf("prueba_segmento: tras cerrar: %s\n", p);
+	if (desproyectar(p) != 0)
+		printf("error desproyectando. NO DEBE APARECER\n");
+	if (desproyectar(p) != -1)
+		printf("doble desproyeccion. NO DEBE APARECER\n");
+
+	dormir(1);	/* hasta que termine el compartidor */
+	if (abrir_segmento("sprueba") >= 0)
+		printf("segmento no destruido. NO DEBE APARECER\n");
+	cerrar_sem(m);
+
+	printf("prueba_segmento: termina\n");
+	return 0;
+}
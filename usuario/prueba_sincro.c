@@ -0,0 +1,125 @@
+/*
+ * usuario/prueba_sincro.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba los semaforos y las variables condicion.
+ * Un productor y un consumidor se comunican por un buffer circular
+ * controlado con dos semaforos. Despues varios hilos esperan en una
+ * condicion hasta que el hilo principal abre la barrera con cond_difundir.
+ */
+
+#include "servicios.h"
+
+#define TAM_BUF 4
+#define NUM_ELEM 20
+#define NUM_ESPERAS 3
+
+static int buf[TAM_BUF];
+static int suma_consumida = 0;
+
+static int abierta = 0;
+static int despiertos = 0;
+
+static int productor(void *arg) {
+	int huecos = abrir_sem("huecos");
+	int items = abrir_sem("items");
+	int i;
+
+	for (i = 1; i <= NUM_ELEM; i++) {
+		sem_esperar(huecos);
+		buf[i % TAM_BUF] = i;
+		sem_senalar(items);
+	}
+	printf("productor termina\n");
+	cerrar_sem(huecos);
+	cerrar_sem(items);
+	return 0;
+}
+
+static int consumidor(void *arg) {
+	int huecos = abrir_sem("huecos");
+	int items = abrir_sem("items");
+	int i;
+
+	for (i = 1; i <= NUM_ELEM; i++) {
+		sem_esperar(items);
+		suma_consumida += buf[i % TAM_BUF];
+		sem_senalar(huecos);
+	}
+	printf("consumidor termina\n");
+	cerrar_sem(huecos);
+	cerrar_sem(items);
+	return 0;
+}
+
+static int esperador(void *arg) {
+	int m = abrir_mutex("mbarr");
+	int c = abrir_cond("cbarr");
+
+	lock(m);
+	while (!abierta)
+		cond_esperar(c, m);
+	despiertos++;
+	unlock(m);
+	printf("esperador %d pasa la barrera\n", (int) (long) arg);
+	cerrar_cond(c);
+	cerrar_mutex(m);
+	return 0;
+}
+
+int main(){
+	int hilos[NUM_ESPERAS];
+	int huecos, items, m, c, prod, cons, i;
+
+	printf("prueba_sincro: comienza\n");
+
+	huecos = crear_sem("huecos", TAM_BUF);
+	items = crear_sem("items", 0);
+	if (huecos < 0 || items < 0)
+		printf("error creando semaforos. NO DEBE APARECER\n");
+	if (crear_sem("huecos", 1) >= 0)
+		printf("semaforo con nombre repetido. NO DEBE APARECER\n");
+	if (lock(huecos) >= 0)
+		printf("lock sobre un semaforo. NO DEBE APARECER\n");
+
+	cons = crear_hilo(consumidor, 0);
+	prod = crear_hilo(productor, 0);
+	esperar_hilo(prod);
+	esperar_hilo(cons);
+	printf("suma consumida: %d. DEBE SER %d\n", suma_consumida,
+		NUM_ELEM * (NUM_ELEM + 1) / 2);
+	cerrar_sem(huecos);
+	cerrar_sem(items);
+
+	m = crear_mutex("mbarr", NO_RECURSIVO);
+	c = crear_cond("cbarr");
+	if (m < 0 || c < 0)
+		printf("error creando mutex o condicion. NO DEBE APARECER\n");
+	if (cond_esperar(c, m) >= 0)
+		printf("cond_esperar sin tener el mutex. NO DEBE APARECER\n");
+
+	for (i = 0; i < NUM_ESPERAS; i++)
+		hilos[i] = crear_hilo(esperador, (void *) (long) i);
+
+	printf("prueba_sincro duerme 1 seg.: los esperadores se bloquean en la condicion\n");
+	dormir(1);
+	lock(m);
+	if (despiertos != 0)
+		printf("esperador pasa la barrera cerrada. NO DEBE APARECER\n");
+	abierta = 1;
+	cond_difundir(c);
+	unlock(m);
+
+	for (i = 0; i < NUM_ESPERAS; i++)
+		esperar_hilo(hilos[i]);
+	printf("esperadores despiertos: %d. DEBE SER %d\n", despiertos, NUM_ESPERAS);
+
+	cerrar_cond(c);
+	cerrar_mutex(m);
+	printf("prueba_sincro: termina\n");
+	return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * usuario/prueba_timeout.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba las llamadas trylock y lock_timeout.
+ * Un hilo intenta obtener un mutex que tiene el hilo principal: sin
+ * esperar, con un plazo que vence y con uno tan largo que no cabe en
+ * ticks, que equivale a esperar sin limite.
+ */
+
+#include "servicios.h"
+
+static int intentador(void *arg) {
+	int m = abrir_mutex("mtiempo");
+	int inicio, ticks, res;
+
+	if (trylock(m) != 1)
+		printf("trylock sobre mutex ocupado no devuelve 1. NO DEBE APARECER\n");
+
+	inicio = tiempos_proceso(0);
+	res = lock_timeout(m, 500);
+	ticks = tiempos_proceso(0) - inicio;
+	printf("lock_timeout de 500 ms devuelve %d tras %d ticks. DEBE SER 1 tras unos 50\n",
+		res, ticks);
+
+	printf("intentador espera sin limite: el mutex se libera antes\n");
+	if (lock_timeout(m, 0xFFFFFFFFu) != 0)
+		printf("lock_timeout no obtiene mutex liberado. NO DEBE APARECER\n");
+	printf("intentador obtiene el mutex\n");
+	unlock(m);
+	cerrar_mutex(m);
+	return 0;
+}
+
+int main(){
+	int m, h;
+
+	printf("prueba_timeout: comienza\n");
+
+	m = crear_mutex("mtiempo", NO_RECURSIVO);
+	if (trylock(m) != 0)
+		printf("trylock sobre mutex libre falla. NO DEBE APARECER\n");
+	if (trylock(m) >= 0)
+		printf("trylock repetido sobre mutex no recursivo. NO DEBE APARECER\n");
+
+	h = crear_hilo(intentador, 0);
+	printf("prueba_timeout duerme 2 seg. con el mutex cerrado\n");
+	dormir(2);
+	unlock(m);
+	esperar_hilo(h);
+
+	if (lock_timeout(m, 100) != 0)
+		printf("lock_timeout sobre mutex libre falla. NO DEBE APARECER\n");
+	unlock(m);
+	cerrar_mutex(m);
+	printf("prueba_timeout: termina\n");
+	return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * usuario/prueba_traspaso.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba la politica TRASPASO de los mutex: los
+ * procesos bloqueados en lock obtienen el mutex en orden FIFO y quien
+ * hace unlock no puede volver a cogerlo mientras haya otros esperando.
+ */
+
+#include "servicios.h"
+
+#define NUM_HILOS 2
+
+static int orden[NUM_HILOS + 1];
+static int num_orden = 0;
+
+static int competidor(void *arg) {
+	int n = (int) (long) arg;
+	int desc;
+
+	if ((desc = abrir_mutex("mtras")) < 0) {
+		printf("competidor %d: error abriendo mutex. NO DEBE APARECER\n", n);
+		return -1;
+	}
+	printf("competidor %d: se bloquea en lock\n", n);
+	lock(desc);
+	printf("competidor %d: obtiene el mutex\n", n);
+	orden[num_orden++] = n;
+	unlock(desc);
+	cerrar_mutex(desc);
+	return 0;
+}
+
+int main(){
+	int hilos[NUM_HILOS];
+	int desc, i;
+
+	printf("prueba_traspaso: comienza\n");
+
+	if ((desc = crear_mutex("mtras", NO_RECURSIVO | TRASPASO)) < 0) {
+		printf("error creando mutex. NO DEBE APARECER\n");
+		terminar_proceso();
+	}
+	if (lock(desc) < 0)
+		printf("error en lock de mutex. NO DEBE APARECER\n");
+
+	for (i = 0; i < NUM_HILOS; i++)
+		hilos[i] = crear_hilo(competidor, (void *) (long) (i + 1));
+
+	printf("prueba_traspaso duerme 1 seg.: los competidores se bloquean en orden\n");
+	dormir(1);
+
+	/* tras el unlock el mutex es del competidor 1: este lock debe bloquear */
+	unlock(desc);
+	lock(desc);
+	orden[num_orden++] = 0;
+	unlock(desc);
+
+	for (i = 0; i < NUM_HILOS; i++)
+		esperar_hilo(hilos[i]);
+
+	for (i = 0; i < num_orden; i++)
+		if (orden[i] != (i + 1) % (NUM_HILOS + 1))
+			printf("orden de obtencion incorrecto. NO DEBE APARECER\n");
+	printf("orden de obtencion: %d %d %d. DEBE SER 1 2 0\n",
+		orden[0], orden[1], orden[2]);
+
+	cerrar_mutex(desc);
+	printf("prueba_traspaso: termina\n");
+	return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * usuario/prueba_tuberia.c
+ *
+ *  Minikernel. Version 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba las tuberias. Crea una tuberia, lanza
+ * el proceso consumidor, que hereda sus descriptores 0 y 1, y le envia
+ * bastantes mas bytes de los que caben en la tuberia. Al cerrar el
+ * extremo de escritura el consumidor ve el fin de los datos.
+ */
+
+#include "servicios.h"
+
+#define TOTAL 10000
+
+int main(){
+	int fds[2], otra[2];
+	char buf[100];
+	int i, enviados = 0;
+
+	printf("prueba_tuberia: comienza\n");
+
+	if (crear_tuberia(fds) < 0 || fds[0] != 0 || fds[1] != 1)
+		printf("error creando la tuberia. NO DEBE APARECER\n");
+	if (crear_proceso("consumidor") < 0)
+		printf("Error creando consumidor\n");
+	cerrar_fd(fds[0]);
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = 'a' + i % 26;
+	while (enviados < TOTAL)
+		enviados += escribir_fd(fds[1], buf, sizeof(buf));
+	printf("prueba_tuberia: enviados %d bytes\n", enviados);
+	cerrar_fd(fds[1]);
+
+	/* sin lectores la escritura falla */
+	crear_tuberia(otra);
+	cerrar_fd(otra[0]);
+	if (escribir_fd(otra[1], buf, 1) != -1)
+		printf("escritura sin lectores. NO DEBE APARECER\n");
+	cerrar_fd(otra[1]);
+	if (leer_fd(fds[0], buf, 1) != -1)
+		printf("lectura de descriptor cerrado. NO DEBE APARECER\n");
+
+	printf("prueba_tuberia: termina\n");
+	return 0;
+}